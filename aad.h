@@ -0,0 +1,234 @@
+#ifndef AAD_H
+#define AAD_H
+
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+#include "arena.h"
+
+// -------------------------
+// Reverse-mode automatic differentiation
+// A Tape records every operation on active numbers as a node holding up
+// up to two parent indices and the local partial derivative toward each. One
+// reverse sweep from an output node then accumulates the adjoint of every
+// node, so the derivatives of that output with respect to all inputs cost
+// a small constant multiple of the recorded forward computation, however
+// many inputs there are. A tape built with several lanes carries an
+// adjoint per output (lane) on each node, so a single sweep serves several
+// outputs. Nodes live in one arena array sized up front; running
+// out throws rather than allocating.
+// Adouble is the active number: a value, its node on the tape, and the
+// tape. Plain doubles convert to constants, which have no node, so
+// arithmetic on constants is not recorded. Code templated on its number
+// type (payoffs, pricing, indicators, GBM) runs unchanged on Adouble.
+// -------------------------
+struct TapeNode {
+    int a, b;          // parent nodes, -1 for none
+    double da, db;     // d(this) / d(parent)
+};
+
+class Tape {
+public:
+    Tape(std::size_t capacity, Arena& arena, int lanes = 1)
+        : capacity_(capacity), size_(0), lanes_(lanes), lane_(nullptr), wide_(nullptr), slots_(0), sweptLanes_(1) {
+        nodes_ = arena.allocArray<TapeNode>(capacity);
+        adjoint_ = arena.allocArray<double>(capacity);
+        if (lanes > 1) {
+            lane_ = arena.allocArray<int>(capacity);
+            wide_ = arena.allocArray<double>(capacity * lanes);
+        }
+    }
+
+    static std::size_t arenaBytes(std::size_t capacity, int lanes = 1) {
+        std::size_t bytes = capacity * (sizeof(TapeNode) + sizeof(double)) + 2 * 64;
+        if (lanes > 1) bytes += capacity * (sizeof(int) + lanes * sizeof(double)) + 2 * 64;
+        return bytes;
+    }
+
+    int record(int a, double da, int b, double db) {
+        if (size_ == capacity_) throw std::runtime_error("AAD tape full; raise aad.tape_nodes");
+        TapeNode& n = nodes_[size_];
+        n.a = a;
+        n.da = da;
+        n.b = b;
+        n.db = db;
+        return (int)size_++;
+    }
+
+    std::size_t size() const { return size_; }
+    std::size_t capacity() const { return capacity_; }
+    void clear() { size_ = 0; }
+
+    // Adjoints of every node recorded up to `output`, with respect to it
+    void reverse(int output) {
+        sweptLanes_ = 1;
+        for (std::size_t i = 0; i < size_; i++) adjoint_[i] = 0.0;
+        if (output < 0) return;
+        adjoint_[output] = 1.0;
+        for (int i = output; i >= 0; i--) {
+            const double w = adjoint_[i];
+            if (w == 0.0) continue;
+            const TapeNode& n = nodes_[i];
+            if (n.a >= 0) adjoint_[n.a] += w * n.da;
+            if (n.b >= 0) adjoint_[n.b] += w * n.db;
+        }
+    }
+
+    // One sweep for N outputs on a tape with N lanes: lane j holds the
+    // adjoints with respect to outputs[j] (-1 leaves the lane zero). Most
+    // nodes feed a single output, so a node keeps one adjoint tagged with
+    // its lane and moves to an N-wide slot only when a second lane reaches
+    // it. Nodes no lane reaches are skipped.
+    template <int N>
+    void reverse(const int (&outputs)[N]) {
+        if (N != lanes_) throw std::logic_error("tape lanes do not match the outputs");
+        sweptLanes_ = N;
+        slots_ = 0;
+        for (std::size_t i = 0; i < size_; i++) lane_[i] = -1;
+        int top = -1;
+        for (int j = 0; j < N; j++) {
+            if (outputs[j] < 0) continue;
+            accumulate<N>(outputs[j], j, 1.0);
+            top = outputs[j] > top ? outputs[j] : top;
+        }
+        for (int i = top; i >= 0; i--) {
+            const int t = lane_[i];
+            if (t < 0) continue;
+            const TapeNode& n = nodes_[i];
+            if (t < N) {
+                const double w = adjoint_[i];
+                if (n.a >= 0) accumulate<N>(n.a, t, w * n.da);
+                if (n.b >= 0) accumulate<N>(n.b, t, w * n.db);
+                continue;
+            }
+            const double* w = wide_ + (std::size_t)(t - N) * N;
+            for (int j = 0; j < N; j++) {
+                if (w[j] == 0.0) continue;
+                if (n.a >= 0) accumulate<N>(n.a, j, w[j] * n.da);
+                if (n.b >= 0) accumulate<N>(n.b, j, w[j] * n.db);
+            }
+        }
+    }
+
+    // After reverse: d(output of lane) / d(node); 0 for constants
+    double adjoint(int node, int lane = 0) const {
+        if (node < 0) return 0.0;
+        if (sweptLanes_ == 1) return lane == 0 ? adjoint_[node] : 0.0;
+        const int t = lane_[node];
+        if (t >= lanes_) return wide_[(std::size_t)(t - lanes_) * lanes_ + lane];
+        return t == lane ? adjoint_[node] : 0.0;
+    }
+
+private:
+    // Adds v to lane j of node i's adjoint, widening the node if another
+    // lane already holds it
+    template <int N>
+    void accumulate(int i, int j, double v) {
+        const int t = lane_[i];
+        if (t < 0) {
+            lane_[i] = j;
+            adjoint_[i] = v;
+            return;
+        }
+        if (t == j) {
+            adjoint_[i] += v;
+            return;
+        }
+        double* w;
+        if (t < N) {
+            w = wide_ + slots_ * N;
+            for (int k = 0; k < N; k++) w[k] = 0.0;
+            w[t] = adjoint_[i];
+            lane_[i] = N + (int)slots_++;
+        } else {
+            w = wide_ + (std::size_t)(t - N) * N;
+        }
+        w[j] += v;
+    }
+
+    std::size_t capacity_;
+    std::size_t size_;
+    int lanes_;
+    TapeNode* nodes_;
+    double* adjoint_;     // one per node: lane 0, or the lane in lane_
+    int* lane_;           // -1 unreached, j < lanes_ lane j only, else lanes_ + wide slot
+    double* wide_;        // lanes_ adjoints per slot
+    std::size_t slots_;   // wide slots in use
+    int sweptLanes_;      // lanes of the last reverse
+};
+
+class Adouble {
+public:
+    Adouble() = default;
+    Adouble(double v) : v_(v), node_(-1), tape_(nullptr) {}
+    Adouble(double v, int node, Tape* tape) : v_(v), node_(node), tape_(tape) {}
+
+    // A new input recorded on the tape
+    static Adouble input(double v, Tape& tape) { return Adouble(v, tape.record(-1, 0.0, -1, 0.0), &tape); }
+
+    double value() const { return v_; }
+    int node() const { return node_; }
+
+    // Result v of an operation on x with d(v)/d(x) = dx
+    static Adouble unary(const Adouble& x, double v, double dx) {
+        if (x.node_ < 0 || dx == 0.0) return Adouble(v);
+        return Adouble(v, x.tape_->record(x.node_, dx, -1, 0.0), x.tape_);
+    }
+
+    // A parent with a zero partial is left out, and a result equal to its
+    // one remaining parent with partial 1 (x * 1, x + 0) reuses its node,
+    // so arithmetic that cannot move the output records nothing
+    static Adouble binary(const Adouble& x, const Adouble& y, double v, double dx, double dy) {
+        const int a = dx != 0.0 ? x.node_ : -1, b = dy != 0.0 ? y.node_ : -1;
+        if (a < 0 && b < 0) return Adouble(v);
+        if (b < 0 && dx == 1.0 && v == x.v_) return Adouble(v, a, x.tape_);
+        if (a < 0 && dy == 1.0 && v == y.v_) return Adouble(v, b, y.tape_);
+        Tape* tape = a >= 0 ? x.tape_ : y.tape_;
+        return Adouble(v, tape->record(a, dx, b, dy), tape);
+    }
+
+    Adouble& operator+=(const Adouble& y) { return *this = binary(*this, y, v_ + y.v_, 1.0, 1.0); }
+    Adouble& operator-=(const Adouble& y) { return *this = binary(*this, y, v_ - y.v_, 1.0, -1.0); }
+    Adouble& operator*=(const Adouble& y) { return *this = binary(*this, y, v_ * y.v_, y.v_, v_); }
+    Adouble& operator/=(const Adouble& y) { return *this = binary(*this, y, v_ / y.v_, 1.0 / y.v_, -v_ / (y.v_ * y.v_)); }
+
+private:
+    double v_;
+    int node_;     // -1 for a constant
+    Tape* tape_;
+};
+
+inline Adouble operator+(const Adouble& x, const Adouble& y) { return Adouble::binary(x, y, x.value() + y.value(), 1.0, 1.0); }
+inline Adouble operator-(const Adouble& x, const Adouble& y) { return Adouble::binary(x, y, x.value() - y.value(), 1.0, -1.0); }
+inline Adouble operator*(const Adouble& x, const Adouble& y) { return Adouble::binary(x, y, x.value() * y.value(), y.value(), x.value()); }
+inline Adouble operator/(const Adouble& x, const Adouble& y) {
+    const double inv = 1.0 / y.value();
+    return Adouble::binary(x, y, x.value() / y.value(), inv, -x.value() * inv * inv);
+}
+inline Adouble operator-(const Adouble& x) { return Adouble::unary(x, -x.value(), -1.0); }
+
+inline bool operator<(const Adouble& x, const Adouble& y) { return x.value() < y.value(); }
+inline bool operator>(const Adouble& x, const Adouble& y) { return x.value() > y.value(); }
+inline bool operator<=(const Adouble& x, const Adouble& y) { return x.value() <= y.value(); }
+inline bool operator>=(const Adouble& x, const Adouble& y) { return x.value() >= y.value(); }
+
+// Found by argument-dependent lookup from templated code that brings the
+// std versions in with using-declarations
+inline Adouble exp(const Adouble& x) {
+    const double e = std::exp(x.value());
+    return Adouble::unary(x, e, e);
+}
+inline Adouble log(const Adouble& x) { return Adouble::unary(x, std::log(x.value()), 1.0 / x.value()); }
+inline Adouble sqrt(const Adouble& x) {
+    const double s = std::sqrt(x.value());
+    return Adouble::unary(x, s, 0.5 / s);
+}
+inline Adouble erfc(const Adouble& x) {
+    return Adouble::unary(x, std::erfc(x.value()), -2.0 / std::sqrt(M_PI) * std::exp(-x.value() * x.value()));
+}
+
+// Plain value of either number type
+inline double valueOf(double x) { return x; }
+inline double valueOf(const Adouble& x) { return x.value(); }
+
+#endif // AAD_H
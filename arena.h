@@ -0,0 +1,163 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
+
+// -------------------------
+// Heap allocation counter
+// Incremented by the replacement operator new in main.cpp when the
+// simulator is built with -DHFT_COUNT_ALLOCS; otherwise it stays at zero.
+// -------------------------
+inline std::atomic<std::size_t>& heapAllocCount() {
+    static std::atomic<std::size_t> count(0);
+    return count;
+}
+
+// Sizes used to pre-size the per-simulation memory (see SimMemory).
+struct MemoryConfig {
+    std::size_t arenaBytes = 4 << 20;   // monotonic arena capacity
+    std::size_t tradePoolSize = 64;     // max trades alive at once
+    std::size_t orderPoolSize = 256;    // max orders in flight
+    bool hugePages = false;             // back the arena with 2MB pages
+};
+
+// -------------------------
+// Monotonic arena
+// One up-front mapping; allocation is a pointer bump and nothing is freed
+// individually. mark()/rewind() give cheap per-tick scratch space.
+// -------------------------
+class Arena {
+public:
+    explicit Arena(std::size_t capacity, bool hugePages = false)
+        : base_(nullptr), capacity_(0), used_(0), mapped_(false), huge_(false) {
+        reserve(capacity, hugePages);
+    }
+    ~Arena() { release(); }
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    void* allocate(std::size_t bytes, std::size_t align = alignof(std::max_align_t)) {
+        std::size_t start = (used_ + align - 1) & ~(align - 1);
+        if (start + bytes > capacity_) throw std::bad_alloc();
+        used_ = start + bytes;
+        return base_ + start;
+    }
+
+    template <class T>
+    T* allocArray(std::size_t n) {
+        return static_cast<T*>(allocate(n * sizeof(T), alignof(T) < 64 ? 64 : alignof(T)));
+    }
+
+    std::size_t mark() const { return used_; }
+    void rewind(std::size_t m) { used_ = m; }
+    void reset() { used_ = 0; }
+
+    std::size_t used() const { return used_; }
+    std::size_t capacity() const { return capacity_; }
+    bool hugePages() const { return huge_; }
+
+private:
+    void reserve(std::size_t capacity, bool hugePages) {
+#ifdef __linux__
+        const std::size_t hugeSize = 2u << 20;
+        if (hugePages) {
+            std::size_t len = (capacity + hugeSize - 1) & ~(hugeSize - 1);
+            void* p = mmap(nullptr, len, PROT_READ | PROT_WRITE,
+                           MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (p != MAP_FAILED) {
+                base_ = static_cast<char*>(p);
+                capacity_ = len;
+                mapped_ = huge_ = true;
+                return;
+            }
+        }
+        void* p = mmap(nullptr, capacity, PROT_READ | PROT_WRITE,
+                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (p == MAP_FAILED) throw std::bad_alloc();
+        // No hugetlbfs reservation: ask for transparent huge pages instead.
+        if (hugePages) madvise(p, capacity, MADV_HUGEPAGE);
+        base_ = static_cast<char*>(p);
+        capacity_ = capacity;
+        mapped_ = true;
+#else
+        (void)hugePages;
+        base_ = static_cast<char*>(::operator new(capacity));
+        capacity_ = capacity;
+#endif
+    }
+
+    void release() {
+        if (!base_) return;
+#ifdef __linux__
+        if (mapped_) munmap(base_, capacity_);
+#else
+        ::operator delete(base_);
+#endif
+        base_ = nullptr;
+    }
+
+    char* base_;
+    std::size_t capacity_;
+    std::size_t used_;
+    bool mapped_;
+    bool huge_;
+};
+
+// -------------------------
+// Fixed-size object pool
+// Slots are carved from an Arena once; acquire/release go through an
+// intrusive free list, so they never touch the heap.
+// -------------------------
+template <class T>
+class ObjectPool {
+public:
+    ObjectPool(Arena& arena, std::size_t capacity)
+        : slots_(arena.allocArray<Slot>(capacity)), capacity_(capacity), inUse_(0) {
+        for (std::size_t i = 0; i + 1 < capacity; i++) slots_[i].next = &slots_[i + 1];
+        if (capacity > 0) slots_[capacity - 1].next = nullptr;
+        free_ = capacity > 0 ? &slots_[0] : nullptr;
+    }
+
+    ObjectPool(const ObjectPool&) = delete;
+    ObjectPool& operator=(const ObjectPool&) = delete;
+
+    // Returns nullptr when the pool is exhausted.
+    T* acquire() {
+        Slot* s = free_;
+        if (!s) return nullptr;
+        free_ = s->next;
+        inUse_++;
+        return new (s->storage) T();
+    }
+
+    void release(T* obj) {
+        obj->~T();
+        Slot* s = reinterpret_cast<Slot*>(obj);
+        s->next = free_;
+        free_ = s;
+        inUse_--;
+    }
+
+    std::size_t capacity() const { return capacity_; }
+    std::size_t inUse() const { return inUse_; }
+
+private:
+    union Slot {
+        Slot* next;
+        alignas(T) unsigned char storage[sizeof(T)];
+    };
+    Slot* slots_;
+    Slot* free_;
+    std::size_t capacity_;
+    std::size_t inUse_;
+};
+
+#endif // ARENA_H
@@ -0,0 +1,763 @@
+#ifndef CONFIG_H
+#define CONFIG_H
+
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <map>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "arena.h"
+
+// -------------------------
+// Config file
+// A small TOML subset: [section] / [section.sub] headers, key = value
+// pairs, '#' comments. Values are strings ("..."), numbers, booleans or
+// flat arrays of those. Keys are stored flattened as "section.key".
+// -------------------------
+class ConfigFile {
+public:
+    void load(const std::string& path) {
+        std::ifstream in(path.c_str());
+        if (!in) throw std::runtime_error("cannot open config file: " + path);
+        std::string line, section;
+        int lineNo = 0;
+        while (std::getline(in, line)) {
+            lineNo++;
+            std::string s = trim(stripComment(line));
+            if (s.empty()) continue;
+            std::string where = path + ":" + std::to_string(lineNo);
+            if (s[0] == '[') {
+                if (s[s.size() - 1] != ']') throw std::runtime_error(where + ": malformed section header");
+                section = trim(s.substr(1, s.size() - 2));
+                continue;
+            }
+            size_t eq = s.find('=');
+            if (eq == std::string::npos) throw std::runtime_error(where + ": expected key = value");
+            std::string key = trim(s.substr(0, eq));
+            std::string value = trim(s.substr(eq + 1));
+            if (key.empty() || value.empty()) throw std::runtime_error(where + ": expected key = value");
+            set(section.empty() ? key : section + "." + key, value);
+        }
+    }
+
+    // Command-line override of the form section.key=value
+    void applyOverride(const std::string& assignment) {
+        size_t eq = assignment.find('=');
+        if (eq == std::string::npos) throw std::runtime_error("bad override (want key=value): " + assignment);
+        set(trim(assignment.substr(0, eq)), trim(assignment.substr(eq + 1)));
+    }
+
+    void set(const std::string& key, const std::string& value) { values_[key] = value; }
+
+    bool has(const std::string& key) const { return values_.count(key) != 0; }
+
+    double getDouble(const std::string& key, double def) const {
+        const std::string* v = lookup(key);
+        return v ? parseDouble(key, *v) : def;
+    }
+
+    long long getInt(const std::string& key, long long def) const {
+        const std::string* v = lookup(key);
+        if (!v) return def;
+        char* end = nullptr;
+        long long x = std::strtoll(v->c_str(), &end, 10);
+        if (*end != '\0') throw std::runtime_error("config key " + key + ": expected integer, got " + *v);
+        return x;
+    }
+
+    bool getBool(const std::string& key, bool def) const {
+        const std::string* v = lookup(key);
+        if (!v) return def;
+        if (*v == "true") return true;
+        if (*v == "false") return false;
+        throw std::runtime_error("config key " + key + ": expected true/false, got " + *v);
+    }
+
+    std::string getString(const std::string& key, const std::string& def) const {
+        const std::string* v = lookup(key);
+        if (!v) return def;
+        if (v->size() >= 2 && (*v)[0] == '"' && (*v)[v->size() - 1] == '"') return v->substr(1, v->size() - 2);
+        return *v;
+    }
+
+    std::vector<double> getDoubleArray(const std::string& key, const std::vector<double>& def) const {
+        const std::string* v = lookup(key);
+        if (!v) return def;
+        std::vector<double> out;
+        std::string body = *v;
+        if (!body.empty() && body[0] == '[') {
+            if (body[body.size() - 1] != ']') throw std::runtime_error("config key " + key + ": unterminated array");
+            body = body.substr(1, body.size() - 2);
+        }
+        std::stringstream ss(body);
+        std::string item;
+        while (std::getline(ss, item, ',')) {
+            item = trim(item);
+            if (!item.empty()) out.push_back(parseDouble(key, item));
+        }
+        return out;
+    }
+
+    // Keys present in the file that no getter asked for (likely typos).
+    std::vector<std::string> unusedKeys() const {
+        std::vector<std::string> out;
+        for (std::map<std::string, std::string>::const_iterator it = values_.begin(); it != values_.end(); ++it)
+            if (!used_.count(it->first)) out.push_back(it->first);
+        return out;
+    }
+
+private:
+    const std::string* lookup(const std::string& key) const {
+        used_.insert(key);
+        std::map<std::string, std::string>::const_iterator it = values_.find(key);
+        return it == values_.end() ? nullptr : &it->second;
+    }
+
+    static double parseDouble(const std::string& key, const std::string& v) {
+        char* end = nullptr;
+        double x = std::strtod(v.c_str(), &end);
+        if (v.empty() || *end != '\0') throw std::runtime_error("config key " + key + ": expected number, got " + v);
+        return x;
+    }
+
+    static std::string stripComment(const std::string& s) {
+        bool inString = false;
+        for (size_t i = 0; i < s.size(); i++) {
+            if (s[i] == '"') inString = !inString;
+            else if (s[i] == '#' && !inString) return s.substr(0, i);
+        }
+        return s;
+    }
+
+    static std::string trim(const std::string& s) {
+        size_t b = s.find_first_not_of(" \t\r\n");
+        if (b == std::string::npos) return "";
+        size_t e = s.find_last_not_of(" \t\r\n");
+        return s.substr(b, e - b + 1);
+    }
+
+    std::map<std::string, std::string> values_;
+    mutable std::set<std::string> used_;
+};
+
+// -------------------------
+// Frozen simulation parameters
+// Everything the hot loop reads is copied out of the ConfigFile into these
+// flat, fixed-size blocks before the loop starts. Strategy blocks are
+// cache-line sized and indexed by strategy type (1..5), like cumulativePnL.
+// -------------------------
+enum RunMode {
+    RUN_SINGLE = 0,   // one path, report per-strategy PnL
+    RUN_PATHS  = 1,   // many independent paths, report PnL statistics
+    RUN_MULTI  = 2,   // correlated multi-asset portfolio
+    RUN_EVENT  = 3,   // event-driven core with irregular arrivals
+    RUN_LATENCY = 4,  // event-driven PnL across a sweep of latency budgets
+    RUN_SWEEP  = 5,   // sharded multi-process sweep over paths and parameters
+    RUN_LSM    = 6,   // Longstaff-Schwartz pricing of an American option
+    RUN_STRESS = 7,   // strategies over a library of shocked scenarios
+    RUN_GATEWAY = 8,  // strategy threads publishing orders to a gateway
+    RUN_FEED   = 9,   // strategies on ticks from a UDP market-data feed
+    RUN_SESSION = 10, // orders over a TCP order-entry session to a local exchange
+    RUN_AAD    = 11   // PnL and option price sensitivities by adjoint AD
+};
+
+struct ModelParams {
+    double S0;       // initial underlying price
+    double mu;       // drift per tick
+    double sigma;    // volatility per tick
+    double dt;       // time step
+};
+
+struct alignas(64) StrategyParams {
+    double entryThreshold;   // volatility level that triggers entry (vol strategies)
+    double exitThreshold;    // volatility level that triggers exit (vol strategies)
+    double strikeOffset;     // relative strike offset (delta)
+    int volume;              // contracts per trade
+    int holdPeriod;          // max holding period in ticks
+    int enabled;
+    // Transaction costs per fill, precomputed from [costs] for this
+    // strategy's legs and volume: cost = feePerFill + (slippage + impact) * S
+    double feePerFill;
+    double slippagePerPrice;
+    double impactPerPrice;
+};
+
+struct PortfolioParams {
+    int assets;                   // number of underlyings
+    double correlation;           // uniform pairwise correlation
+    int block;                    // tile size for the Cholesky mat-vec
+    std::string correlationFile;  // optional n x n CSV, overrides correlation
+};
+
+// Synthetic option chain; vols are per tick and expiries are in ticks
+struct ChainParams {
+    int enabled;
+    int strikes;            // listed strikes per expiry
+    int expiries;           // listed expiries
+    double strikeSpacing;   // strike spacing relative to the spot at listing
+    int firstExpiry;        // ticks to the front expiry
+    int expirySpacing;      // ticks between expiries
+    double atmVol;          // surface level
+    double skew;            // slope in standardised moneyness
+    double smile;           // curvature in standardised moneyness
+    double termSlope;       // vol scales with (T / firstExpiry)^termSlope
+    double minVol;          // floor on surface vol
+    double volNoise;        // relative per-tick noise on the surface level
+    double spread;          // half-spread as a fraction of mid
+    double tickSize;        // minimum full spread
+};
+
+// Event-driven core; times in nanoseconds of simulated time
+struct EventParams {
+    double meanIntervalNs;    // mean gap between market data events (one model dt)
+    int poisson;              // exponential gaps if set, fixed gaps otherwise
+    uint64_t holdTimeNs[6];   // holding timer per strategy
+};
+
+// Latency jitter distributions; each has mean jitterNs above the base
+enum LatencyDist {
+    LAT_FIXED = 0,
+    LAT_UNIFORM = 1,
+    LAT_EXPONENTIAL = 2,
+    LAT_LOGNORMAL = 3
+};
+
+struct LatencyComponent {
+    double baseNs;
+    double jitterNs;
+    int dist;
+};
+
+// Order latency and queue position (event-driven modes)
+struct LatencyParams {
+    int enabled;
+    LatencyComponent wire;       // each direction
+    LatencyComponent gateway;
+    LatencyComponent matching;
+    int limitOrders;             // rest at the signal price instead of crossing
+    double queueDepth;           // mean displayed volume ahead on arrival
+    double tradeVolume;          // mean volume traded per market data event
+    uint64_t limitTimeoutNs;     // resting limits cross after this long
+    std::vector<double> sweepNs; // mean outbound budgets for the latency mode
+};
+
+// Multi-process sweep: run.paths paths for every value of one parameter
+struct SweepParams {
+    int workers;                  // forked worker processes
+    int shardPaths;               // paths per unit of work
+    std::string param;            // config key to sweep, empty for none
+    std::vector<double> values;   // values for param
+};
+
+// On-disk cache of generated paths (single, paths and sweep modes)
+struct CacheParams {
+    int enabled;
+    std::string dir;   // created if missing
+};
+
+// Live telemetry in a POSIX shared-memory object (single and paths modes)
+struct TelemetryParams {
+    int enabled;
+    std::string name;    // shm_open name, e.g. "/hft_telemetry"
+    int intervalTicks;   // ticks between snapshots
+};
+
+// Longstaff-Schwartz Monte Carlo (lsm mode); times in model time units
+struct LsmParams {
+    int paths;
+    int exerciseDates;   // equally spaced, the last at maturity
+    double maturity;
+    double strike;
+    int isCall;
+    int basisDegree;     // polynomial degree of the regression in S/K
+    int threads;
+    double rate;         // risk-free rate per model time unit
+    int greeks;          // Monte Carlo Greeks on the same paths
+};
+
+// UDP market-data feed ("feed" mode)
+struct FeedParams {
+    std::string group;       // multicast group, or a unicast address to bind
+    std::string interface;   // local address to join the group on
+    int port;
+    int batch;               // datagrams per recvmmsg call
+    int busyPoll;            // spin on non-blocking receives
+    int idleTimeoutMs;       // give up after this long without data
+    int rcvbufBytes;
+    // Publisher (hft_publisher)
+    std::string tickFile;    // one price per line; empty = the GBM path for run.seed
+    double rate;             // ticks per second, 0 = as fast as possible
+    int ticksPerPacket;
+    int dropEvery;           // skip every Nth packet to exercise gap detection, 0 = none
+};
+
+enum SessionEncoding { ENCODING_BINARY = 0, ENCODING_FIX = 1 };
+
+// TCP order-entry session to the local matching engine ("session" mode)
+struct SessionParams {
+    int encoding;        // SessionEncoding
+    int port;            // loopback port the engine listens on, 0 = any free port
+    int bufferBytes;     // send and receive buffer per side
+};
+
+// Adjoint sensitivities ("aad" mode)
+struct AadParams {
+    double smoothing;      // signal smoothing width, in model tick volatilities; 0 = hard signals
+    double prune;          // drop position weight below this
+    size_t tapeNodes;      // tape capacity, 0 = sized from run.ticks
+    int check;             // compare against bump-and-revalue
+};
+
+// Pre-trade limits, per instrument (one per strategy)
+struct RiskParams {
+    int enabled;
+    int maxPosition;       // contracts
+    int maxOpenOrders;
+    double maxNotional;    // contracts x underlying price
+    double priceBandBps;   // fat-finger band around the last price
+    double maxLoss;        // realised loss that stops new entries
+};
+
+// Order gateway: one SPSC ring per strategy, drained in batches
+struct GatewayParams {
+    int queueCapacity;   // intents per ring, a power of two
+    int batch;           // most intents taken from one ring per visit
+};
+
+// Stress scenarios: each size of each kind at every start tick
+struct StressParams {
+    std::vector<double> gaps;        // jump returns, e.g. -0.1
+    std::vector<double> volSpikes;   // log-return multipliers
+    std::vector<double> crashes;     // flash-crash depths, recovered over the window
+    std::vector<double> trends;      // extra drift per tick
+    int starts;                      // start ticks, spread over the run
+    int window;                      // ticks a spike, crash or trend lasts
+    int threads;
+    std::string output;              // optional CSV of the full matrix
+};
+
+// Listed expiries and settlement of the strategies' options (single,
+// paths, sweep and multi modes)
+struct ExpiryParams {
+    int enabled;
+    int cycle;           // ticks between listed expiries
+    int minTicks;        // shortest time to expiry a new trade accepts
+    double rate;         // risk-free rate per model time unit
+};
+
+enum LatticeMethod { LATTICE_BINOMIAL = 0, LATTICE_TRINOMIAL = 1 };
+
+// American lattice marking of open positions (single, paths, sweep modes)
+struct AmericanParams {
+    int enabled;
+    int method;          // LatticeMethod
+    int steps;           // tree steps to expiry
+    int richardson;      // extrapolate from steps and steps / 2
+    double rate;         // risk-free rate per model time unit
+};
+
+// Trend line of the moving-average crossover
+enum TrendIndicator { TREND_SMA = 0, TREND_EMA, TREND_DEMA, TREND_KAMA, TREND_MEDIAN };
+
+// Volatility the vol strategies' thresholds are compared against
+enum VolIndicator { VOL_WINDOW = 0, VOL_REGIME, VOL_QUANTILE };
+
+struct SimParams {
+    int mode;
+    int totalTicks;
+    int paths;
+    int batch;               // ticks per stage call; 1 = per-tick loop
+    uint64_t seed;           // 0 = seed from the clock
+    ModelParams model;
+    // Indicator windows (in ticks)
+    int shortWindow;
+    int longWindow;
+    int volWindow;
+    int trend;               // TrendIndicator for both crossover lines
+    int atrBar;              // ticks per synthetic ATR bar (streaming bank)
+    int volSource;           // VolIndicator
+    double regimeLowVol;     // per-tick volatility of the calm regime
+    double regimeHighVol;    // and of the turbulent one
+    double regimeSwitch;     // probability per tick of changing regime
+    double volQuantile;      // quantile of |return| behind the robust volatility
+    StrategyParams strategy[6];   // index 1..5, slot 0 unused
+    int costs;                    // transaction costs charged on fills
+    PortfolioParams portfolio;
+    ChainParams chain;
+    EventParams event;
+    LatencyParams latency;
+    SweepParams sweep;
+    CacheParams cache;
+    AmericanParams american;
+    ExpiryParams expiry;
+    LsmParams lsm;
+    StressParams stress;
+    GatewayParams gateway;
+    RiskParams risk;
+    FeedParams feed;
+    SessionParams session;
+    AadParams aad;
+    TelemetryParams telemetry;
+    MemoryConfig memory;
+};
+
+static const char* const kStrategyKeys[6] = {"", "straddle", "strangle", "bull", "bear", "butterfly"};
+// Option contracts per unit of volume (legs, with the butterfly's 2x body)
+static const int kLegContracts[6] = {0, 2, 2, 2, 2, 4};
+static const char* const kStrategyNames[6] = {"", "Straddle", "Strangle", "Bull Spread", "Bear Spread", "Butterfly Spread"};
+
+// Reads <prefix>_ns, <prefix>_jitter_ns and <prefix>_dist
+inline LatencyComponent readLatencyComponent(const ConfigFile& cfg, const std::string& prefix,
+                                             double baseNs, double jitterNs) {
+    LatencyComponent c;
+    c.baseNs   = cfg.getDouble(prefix + "_ns", baseNs);
+    c.jitterNs = cfg.getDouble(prefix + "_jitter_ns", jitterNs);
+    std::string dist = cfg.getString(prefix + "_dist", "exponential");
+    if (dist == "fixed") c.dist = LAT_FIXED;
+    else if (dist == "uniform") c.dist = LAT_UNIFORM;
+    else if (dist == "exponential") c.dist = LAT_EXPONENTIAL;
+    else if (dist == "lognormal") c.dist = LAT_LOGNORMAL;
+    else throw std::runtime_error("unknown " + prefix + "_dist: " + dist);
+    return c;
+}
+
+// Builds the frozen parameter set. Missing keys take the defaults the
+// simulator historically hardcoded, so an empty config reproduces the
+// original run.
+inline SimParams freezeSimParams(const ConfigFile& cfg) {
+    SimParams p;
+    std::string mode = cfg.getString("run.mode", "single");
+    if (mode == "single") p.mode = RUN_SINGLE;
+    else if (mode == "paths") p.mode = RUN_PATHS;
+    else if (mode == "multi") p.mode = RUN_MULTI;
+    else if (mode == "event") p.mode = RUN_EVENT;
+    else if (mode == "latency") p.mode = RUN_LATENCY;
+    else if (mode == "sweep") p.mode = RUN_SWEEP;
+    else if (mode == "lsm") p.mode = RUN_LSM;
+    else if (mode == "stress") p.mode = RUN_STRESS;
+    else if (mode == "gateway") p.mode = RUN_GATEWAY;
+    else if (mode == "feed") p.mode = RUN_FEED;
+    else if (mode == "session") p.mode = RUN_SESSION;
+    else if (mode == "aad") p.mode = RUN_AAD;
+    else throw std::runtime_error("unknown run.mode: " + mode);
+    p.totalTicks = (int)cfg.getInt("run.ticks", 10000);
+    p.paths      = (int)cfg.getInt("run.paths", 1);
+    p.batch      = (int)cfg.getInt("run.batch", 1);
+    p.seed       = (uint64_t)cfg.getInt("run.seed", 0);
+
+    std::string model = cfg.getString("model.type", "gbm");
+    if (model != "gbm") throw std::runtime_error("unknown model.type: " + model);
+    p.model.S0    = cfg.getDouble("model.S0", 100.0);
+    p.model.mu    = cfg.getDouble("model.mu", 0.0001);
+    p.model.sigma = cfg.getDouble("model.sigma", 0.01);
+    p.model.dt    = cfg.getDouble("model.dt", 1.0);
+
+    p.shortWindow = (int)cfg.getInt("indicators.short_window", 5);
+    p.longWindow  = (int)cfg.getInt("indicators.long_window", 20);
+    p.volWindow   = (int)cfg.getInt("indicators.vol_window", 5);
+    std::string trend = cfg.getString("indicators.trend", "sma");
+    if (trend == "sma") p.trend = TREND_SMA;
+    else if (trend == "ema") p.trend = TREND_EMA;
+    else if (trend == "dema") p.trend = TREND_DEMA;
+    else if (trend == "kama") p.trend = TREND_KAMA;
+    else if (trend == "median") p.trend = TREND_MEDIAN;
+    else throw std::runtime_error("unknown indicators.trend: " + trend);
+    p.atrBar      = (int)cfg.getInt("indicators.atr_bar", 10);
+    std::string vol = cfg.getString("indicators.vol", "window");
+    if (vol == "window") p.volSource = VOL_WINDOW;
+    else if (vol == "regime") p.volSource = VOL_REGIME;
+    else if (vol == "quantile") p.volSource = VOL_QUANTILE;
+    else throw std::runtime_error("unknown indicators.vol: " + vol);
+    const double tickVol = p.model.sigma * std::sqrt(p.model.dt);
+    p.regimeLowVol  = cfg.getDouble("indicators.regime_low_vol", 0.4 * tickVol);
+    p.regimeHighVol = cfg.getDouble("indicators.regime_high_vol", 2.0 * tickVol);
+    p.regimeSwitch  = cfg.getDouble("indicators.regime_switch", 0.01);
+    if (!(p.regimeLowVol > 0.0) || !(p.regimeHighVol > p.regimeLowVol))
+        throw std::runtime_error("indicators.regime_high_vol must exceed regime_low_vol > 0");
+    if (!(p.regimeSwitch > 0.0) || !(p.regimeSwitch < 0.5))
+        throw std::runtime_error("indicators.regime_switch must be in (0, 0.5)");
+    p.volQuantile   = cfg.getDouble("indicators.vol_quantile", 0.5);
+    if (!(p.volQuantile > 0.0) || !(p.volQuantile < 1.0))
+        throw std::runtime_error("indicators.vol_quantile must be in (0, 1)");
+
+    double delta   = cfg.getDouble("strategy.strike_offset", 0.05);
+    int volume     = (int)cfg.getInt("strategy.volume", 10);
+    int holdPeriod = (int)cfg.getInt("strategy.hold_period", 10);
+    const double entryDefaults[6] = {0, 0.01, 0.012, 0, 0, 0.005};
+    const double exitDefaults[6]  = {0, 0.005, 0.007, 0, 0, 0.005};
+    p.strategy[0] = StrategyParams();
+    for (int i = 1; i <= 5; i++) {
+        std::string prefix = std::string("strategy.") + kStrategyKeys[i] + ".";
+        StrategyParams& s = p.strategy[i];
+        s.enabled        = cfg.getBool(prefix + "enabled", true) ? 1 : 0;
+        s.entryThreshold = cfg.getDouble(prefix + "entry_vol", entryDefaults[i]);
+        s.exitThreshold  = cfg.getDouble(prefix + "exit_vol", exitDefaults[i]);
+        s.strikeOffset   = cfg.getDouble(prefix + "strike_offset", delta);
+        s.volume         = (int)cfg.getInt(prefix + "volume", volume);
+        s.holdPeriod     = (int)cfg.getInt(prefix + "hold_period", holdPeriod);
+    }
+    // The regime volatility stays within [regime_low_vol, regime_high_vol],
+    // so a threshold on or outside that range could never fire
+    if (p.volSource == VOL_REGIME) {
+        const int volStrategies[3] = {1, 2, 5};   // straddle, strangle, butterfly
+        for (int j = 0; j < 3; j++) {
+            const StrategyParams& s = p.strategy[volStrategies[j]];
+            if (s.enabled && !(s.entryThreshold > p.regimeLowVol && s.entryThreshold < p.regimeHighVol
+                               && s.exitThreshold > p.regimeLowVol && s.exitThreshold < p.regimeHighVol))
+                throw std::runtime_error(std::string("strategy.") + kStrategyKeys[volStrategies[j]]
+                                         + " thresholds must lie strictly between the regime volatilities");
+        }
+    }
+
+    // Costs: per-contract commission and exchange fee, half spread plus
+    // slippage in bps of the underlying, and square-root impact
+    // coeff * sqrt(contracts / adv) as a fraction of the underlying
+    p.costs               = cfg.getBool("costs.enabled", false) ? 1 : 0;
+    double feePerContract = cfg.getDouble("costs.fee_per_contract", 0.5);
+    double exchangeFee    = cfg.getDouble("costs.exchange_fee", 0.1);
+    double halfSpreadBps  = cfg.getDouble("costs.half_spread_bps", 2.0);
+    double slippageBps    = cfg.getDouble("costs.slippage_bps", 1.0);
+    double impactCoeff    = cfg.getDouble("costs.impact_coeff", 0.001);
+    double adv            = cfg.getDouble("costs.adv", 10000.0);
+    if (adv <= 0.0) throw std::runtime_error("costs.adv must be positive");
+    for (int i = 1; i <= 5; i++) {
+        StrategyParams& s = p.strategy[i];
+        double contracts = (double)s.volume * kLegContracts[i];
+        s.feePerFill       = p.costs ? contracts * (feePerContract + exchangeFee) : 0.0;
+        s.slippagePerPrice = p.costs ? contracts * (halfSpreadBps + slippageBps) * 1e-4 : 0.0;
+        s.impactPerPrice   = p.costs ? contracts * impactCoeff * std::sqrt(contracts / adv) : 0.0;
+    }
+
+    PortfolioParams& pp = p.portfolio;
+    pp.assets          = (int)cfg.getInt("portfolio.assets", 100);
+    pp.correlation     = cfg.getDouble("portfolio.correlation", 0.3);
+    pp.block           = (int)cfg.getInt("portfolio.block", 32);
+    pp.correlationFile = cfg.getString("portfolio.correlation_file", "");
+
+    ChainParams& ch = p.chain;
+    ch.enabled       = cfg.getBool("chain.enabled", false) ? 1 : 0;
+    ch.strikes       = (int)cfg.getInt("chain.strikes", 25);
+    ch.expiries      = (int)cfg.getInt("chain.expiries", 20);
+    ch.strikeSpacing = cfg.getDouble("chain.strike_spacing", 0.01);
+    ch.firstExpiry   = (int)cfg.getInt("chain.first_expiry", 100);
+    ch.expirySpacing = (int)cfg.getInt("chain.expiry_spacing", 100);
+    ch.atmVol        = cfg.getDouble("chain.atm_vol", p.model.sigma);
+    ch.skew          = cfg.getDouble("chain.skew", -0.1);
+    ch.smile         = cfg.getDouble("chain.smile", 0.05);
+    ch.termSlope     = cfg.getDouble("chain.term_slope", -0.05);
+    ch.minVol        = cfg.getDouble("chain.min_vol", 0.1 * ch.atmVol);
+    ch.volNoise      = cfg.getDouble("chain.vol_noise", 0.02);
+    ch.spread        = cfg.getDouble("chain.spread", 0.01);
+    ch.tickSize      = cfg.getDouble("chain.tick_size", 0.01);
+    if (ch.strikes < 4 || ch.expiries < 1 || ch.firstExpiry < 1 || ch.expirySpacing < 1)
+        throw std::runtime_error("chain needs at least 4 strikes, 1 expiry and positive expiry spacing");
+    if (ch.strikeSpacing <= 0.0 || (ch.strikes / 2) * ch.strikeSpacing >= 1.0)
+        throw std::runtime_error("chain.strike_spacing must be positive and below 1 / (chain.strikes / 2) so every strike is positive");
+    // Only runSimulation's tick loop snaps strikes to the chain
+    if (ch.enabled && (p.mode == RUN_MULTI || p.mode == RUN_EVENT || p.mode == RUN_LATENCY || p.mode == RUN_STRESS
+                       || p.mode == RUN_FEED || p.mode == RUN_GATEWAY || p.mode == RUN_SESSION))
+        throw std::runtime_error("option chain is not supported in " + mode + " mode");
+
+    // Holding timers default to each strategy's hold_period in mean gaps
+    EventParams& ev = p.event;
+    ev.meanIntervalNs = cfg.getDouble("event.mean_interval_ns", 1000.0);
+    std::string arrivals = cfg.getString("event.arrivals", "poisson");
+    if (arrivals != "poisson" && arrivals != "uniform") throw std::runtime_error("unknown event.arrivals: " + arrivals);
+    ev.poisson = arrivals == "poisson" ? 1 : 0;
+    long long holdTime = cfg.getInt("event.hold_time_ns", 0);
+    ev.holdTimeNs[0] = 0;
+    for (int i = 1; i <= 5; i++)
+        ev.holdTimeNs[i] = holdTime > 0 ? (uint64_t)holdTime
+                                        : (uint64_t)(p.strategy[i].holdPeriod * ev.meanIntervalNs);
+    if (ev.meanIntervalNs < 1.0) throw std::runtime_error("event.mean_interval_ns must be at least 1");
+
+    LatencyParams& lp = p.latency;
+    // The latency sweep is meaningless without the model, so it is always on there
+    lp.enabled  = cfg.getBool("latency.enabled", false) || p.mode == RUN_LATENCY ? 1 : 0;
+    lp.wire     = readLatencyComponent(cfg, "latency.wire", 2000, 200);
+    lp.gateway  = readLatencyComponent(cfg, "latency.gateway", 1000, 300);
+    lp.matching = readLatencyComponent(cfg, "latency.matching", 500, 100);
+    std::string orderType = cfg.getString("latency.order_type", "market");
+    if (orderType != "market" && orderType != "limit") throw std::runtime_error("unknown latency.order_type: " + orderType);
+    lp.limitOrders    = orderType == "limit" ? 1 : 0;
+    lp.queueDepth     = cfg.getDouble("latency.queue_depth", 500.0);
+    lp.tradeVolume    = cfg.getDouble("latency.trade_volume", 100.0);
+    lp.limitTimeoutNs = (uint64_t)cfg.getInt("latency.limit_timeout_ns", 50000);
+    const double sweepDefaults[] = {0, 1000, 3000, 10000, 30000, 100000};
+    lp.sweepNs = cfg.getDoubleArray("latency.sweep_ns", std::vector<double>(sweepDefaults, sweepDefaults + 6));
+    if (lp.enabled && p.mode != RUN_EVENT && p.mode != RUN_LATENCY)
+        throw std::runtime_error("latency model needs run.mode = event or latency");
+
+    SweepParams& sw = p.sweep;
+    sw.workers    = (int)cfg.getInt("sweep.workers", 4);
+    sw.shardPaths = (int)cfg.getInt("sweep.shard_paths", 16);
+    sw.param      = cfg.getString("sweep.param", "");
+    sw.values     = cfg.getDoubleArray("sweep.values", std::vector<double>());
+    if (sw.workers < 1 || sw.shardPaths < 1) throw std::runtime_error("sweep.workers and sweep.shard_paths must be positive");
+    if (!sw.param.empty() && sw.values.empty()) throw std::runtime_error("sweep.param needs sweep.values");
+
+    CacheParams& cp = p.cache;
+    cp.enabled = cfg.getBool("cache.enabled", false) ? 1 : 0;
+    cp.dir     = cfg.getString("cache.dir", "path_cache");
+    if (cp.enabled && p.mode != RUN_SINGLE && p.mode != RUN_PATHS && p.mode != RUN_SWEEP)
+        throw std::runtime_error("path cache needs run.mode = single, paths or sweep");
+    if (cp.enabled && p.seed == 0) throw std::runtime_error("path cache needs a fixed run.seed");
+
+    AmericanParams& ap = p.american;
+    ap.enabled    = cfg.getBool("american.enabled", false) ? 1 : 0;
+    std::string method = cfg.getString("american.method", "binomial");
+    if (method == "binomial") ap.method = LATTICE_BINOMIAL;
+    else if (method == "trinomial") ap.method = LATTICE_TRINOMIAL;
+    else throw std::runtime_error("unknown american.method: " + method);
+    ap.steps      = (int)cfg.getInt("american.steps", 64);
+    ap.richardson = cfg.getBool("american.richardson", true) ? 1 : 0;
+    ap.rate       = cfg.getDouble("american.rate", 0.0);
+    // Richardson needs steps and steps / 2 of the same (even) parity, or
+    // the binomial odd-even oscillation swamps the correction
+    if (ap.steps < 2 || (ap.richardson && (ap.steps < 4 || ap.steps % 4)))
+        throw std::runtime_error("american.steps must be at least 2 (a multiple of 4 with richardson)");
+    if (ap.enabled && p.mode != RUN_SINGLE && p.mode != RUN_PATHS && p.mode != RUN_SWEEP)
+        throw std::runtime_error("american marking needs run.mode = single, paths or sweep");
+
+    ExpiryParams& ex = p.expiry;
+    ex.enabled  = cfg.getBool("expiry.enabled", false) ? 1 : 0;
+    ex.cycle    = (int)cfg.getInt("expiry.cycle", 50);
+    ex.minTicks = (int)cfg.getInt("expiry.min_ticks", 5);
+    ex.rate     = cfg.getDouble("expiry.rate", 0.0);
+    if (ex.cycle < 1 || ex.minTicks < 1) throw std::runtime_error("expiry.cycle and expiry.min_ticks must be positive");
+    if (ex.enabled && p.mode != RUN_SINGLE && p.mode != RUN_PATHS && p.mode != RUN_SWEEP && p.mode != RUN_MULTI)
+        throw std::runtime_error("option expiries need run.mode = single, paths, sweep or multi");
+
+    LsmParams& ls = p.lsm;
+    ls.paths         = (int)cfg.getInt("lsm.paths", 20000);
+    ls.exerciseDates = (int)cfg.getInt("lsm.exercise_dates", 50);
+    ls.maturity      = cfg.getDouble("lsm.maturity", 50.0);
+    ls.strike        = cfg.getDouble("lsm.strike", p.model.S0);
+    std::string type  = cfg.getString("lsm.type", "put");
+    if (type != "put" && type != "call") throw std::runtime_error("unknown lsm.type: " + type);
+    ls.isCall        = type == "call" ? 1 : 0;
+    ls.basisDegree   = (int)cfg.getInt("lsm.basis_degree", 3);
+    ls.threads       = (int)cfg.getInt("lsm.threads", 4);
+    ls.rate          = cfg.getDouble("lsm.rate", 0.001);
+    ls.greeks        = cfg.getBool("lsm.greeks", false) ? 1 : 0;
+    if (ls.paths < 1 || ls.exerciseDates < 1 || ls.maturity <= 0.0 || ls.strike <= 0.0 || ls.threads < 1)
+        throw std::runtime_error("lsm paths, exercise_dates, maturity, strike and threads must be positive");
+    if (ls.basisDegree < 1 || ls.basisDegree > 7) throw std::runtime_error("lsm.basis_degree must be 1..7");
+
+    FeedParams& fd = p.feed;
+    fd.group         = cfg.getString("feed.group", "239.255.0.1");
+    fd.interface     = cfg.getString("feed.interface", "127.0.0.1");
+    fd.port          = (int)cfg.getInt("feed.port", 30001);
+    fd.batch         = (int)cfg.getInt("feed.batch", 32);
+    fd.busyPoll      = cfg.getBool("feed.busy_poll", false) ? 1 : 0;
+    fd.idleTimeoutMs = (int)cfg.getInt("feed.idle_timeout_ms", 5000);
+    fd.rcvbufBytes   = (int)cfg.getInt("feed.rcvbuf_bytes", 4 << 20);
+    fd.tickFile       = cfg.getString("feed.tick_file", "");
+    fd.rate           = cfg.getDouble("feed.rate", 100000.0);
+    fd.ticksPerPacket = (int)cfg.getInt("feed.ticks_per_packet", 16);
+    fd.dropEvery      = (int)cfg.getInt("feed.drop_every", 0);
+    if (fd.ticksPerPacket < 1 || fd.ticksPerPacket > 90)
+        throw std::runtime_error("feed.ticks_per_packet must be in 1..90");
+    if (fd.rate < 0.0 || fd.dropEvery < 0) throw std::runtime_error("feed.rate and feed.drop_every must be non-negative");
+    if (fd.port < 1 || fd.port > 65535) throw std::runtime_error("feed.port must be in 1..65535");
+    if (fd.batch < 1 || fd.idleTimeoutMs < 1 || fd.rcvbufBytes < 1)
+        throw std::runtime_error("feed.batch, feed.idle_timeout_ms and feed.rcvbuf_bytes must be positive");
+
+    SessionParams& ss = p.session;
+    std::string encoding = cfg.getString("session.encoding", "binary");
+    if (encoding == "binary") ss.encoding = ENCODING_BINARY;
+    else if (encoding == "fix") ss.encoding = ENCODING_FIX;
+    else throw std::runtime_error("unknown session.encoding: " + encoding);
+    ss.port        = (int)cfg.getInt("session.port", 0);
+    ss.bufferBytes = (int)cfg.getInt("session.buffer_bytes", 65536);
+    if (ss.port < 0 || ss.port > 65535) throw std::runtime_error("session.port must be in 0..65535");
+    if (ss.bufferBytes < 1024) throw std::runtime_error("session.buffer_bytes must be at least 1024");
+
+    AadParams& ad = p.aad;
+    ad.smoothing = cfg.getDouble("aad.smoothing", 0.01);
+    ad.prune     = cfg.getDouble("aad.prune", 1e-9);
+    ad.tapeNodes = (size_t)cfg.getInt("aad.tape_nodes", 0);
+    ad.check     = cfg.getBool("aad.check", true) ? 1 : 0;
+    if (ad.smoothing < 0.0 || ad.prune < 0.0 || ad.prune >= 1.0)
+        throw std::runtime_error("aad.smoothing must be non-negative and aad.prune in [0, 1)");
+
+    RiskParams& rk = p.risk;
+    rk.enabled       = cfg.getBool("risk.enabled", false) ? 1 : 0;
+    rk.maxPosition   = (int)cfg.getInt("risk.max_position", 100);
+    rk.maxOpenOrders = (int)cfg.getInt("risk.max_open_orders", 4);
+    rk.maxNotional   = cfg.getDouble("risk.max_notional", 1e6);
+    rk.priceBandBps  = cfg.getDouble("risk.price_band_bps", 500.0);
+    rk.maxLoss       = cfg.getDouble("risk.max_loss", 1e6);
+    if (rk.maxPosition < 1 || rk.maxOpenOrders < 1)
+        throw std::runtime_error("risk.max_position and risk.max_open_orders must be at least 1");
+    if (rk.maxNotional <= 0.0 || rk.priceBandBps <= 0.0 || rk.maxLoss < 0.0)
+        throw std::runtime_error("risk.max_notional and risk.price_band_bps must be positive, risk.max_loss non-negative");
+    // Portfolio books and the LSM pricer place no orders through a risk engine
+    if (rk.enabled && (p.mode == RUN_MULTI || p.mode == RUN_LSM))
+        throw std::runtime_error("risk checks are not supported in " + mode + " mode");
+
+    GatewayParams& gw = p.gateway;
+    gw.queueCapacity = (int)cfg.getInt("gateway.queue_capacity", 1024);
+    gw.batch         = (int)cfg.getInt("gateway.batch", 64);
+    if (gw.queueCapacity < 2 || (gw.queueCapacity & (gw.queueCapacity - 1)))
+        throw std::runtime_error("gateway.queue_capacity must be a power of two");
+    if (gw.batch < 1) throw std::runtime_error("gateway.batch must be at least 1");
+
+    StressParams& st = p.stress;
+    const double gapDefaults[] = {-0.1, -0.05, 0.05, 0.1};
+    const double spikeDefaults[] = {2.0, 3.0, 5.0};
+    const double crashDefaults[] = {0.05, 0.1, 0.2};
+    const double trendDefaults[] = {-0.001, -0.0005, 0.0005, 0.001};
+    st.gaps      = cfg.getDoubleArray("stress.gaps", std::vector<double>(gapDefaults, gapDefaults + 4));
+    st.volSpikes = cfg.getDoubleArray("stress.vol_spikes", std::vector<double>(spikeDefaults, spikeDefaults + 3));
+    st.crashes   = cfg.getDoubleArray("stress.crashes", std::vector<double>(crashDefaults, crashDefaults + 3));
+    st.trends    = cfg.getDoubleArray("stress.trends", std::vector<double>(trendDefaults, trendDefaults + 4));
+    st.starts    = (int)cfg.getInt("stress.starts", 10);
+    st.window    = (int)cfg.getInt("stress.window", 500);
+    st.threads   = (int)cfg.getInt("stress.threads", 4);
+    st.output    = cfg.getString("stress.output", "");
+    if (st.starts < 1 || st.window < 1 || st.threads < 1)
+        throw std::runtime_error("stress.starts, stress.window and stress.threads must be positive");
+    for (size_t i = 0; i < st.gaps.size(); i++)
+        if (st.gaps[i] <= -1.0) throw std::runtime_error("stress.gaps must be above -1");
+    for (size_t i = 0; i < st.crashes.size(); i++)
+        if (st.crashes[i] <= 0.0 || st.crashes[i] >= 1.0) throw std::runtime_error("stress.crashes must be in (0, 1)");
+
+    TelemetryParams& tp = p.telemetry;
+    tp.enabled       = cfg.getBool("telemetry.enabled", false) ? 1 : 0;
+    tp.name          = cfg.getString("telemetry.name", "/hft_telemetry");
+    tp.intervalTicks = (int)cfg.getInt("telemetry.interval_ticks", 1000);
+    if (tp.enabled && p.mode != RUN_SINGLE && p.mode != RUN_PATHS)
+        throw std::runtime_error("telemetry needs run.mode = single or paths");
+    if (tp.intervalTicks < 1) throw std::runtime_error("telemetry.interval_ticks must be positive");
+    if (tp.name.empty() || tp.name[0] != '/') throw std::runtime_error("telemetry.name must start with '/'");
+
+    // Sizes left at 0 are filled in per run mode by the caller
+    MemoryConfig& m = p.memory;
+    m.arenaBytes    = (size_t)cfg.getInt("memory.arena_bytes", 0);
+    m.tradePoolSize = (size_t)cfg.getInt("memory.trade_pool", 0);
+    m.orderPoolSize = (size_t)cfg.getInt("memory.order_pool", (long long)m.orderPoolSize);
+    m.hugePages     = cfg.getBool("memory.huge_pages", false);
+
+    if (p.totalTicks < 2) throw std::runtime_error("run.ticks must be at least 2");
+    if (p.paths < 1) throw std::runtime_error("run.paths must be at least 1");
+    if (p.batch < 1) throw std::runtime_error("run.batch must be at least 1");
+    if (p.shortWindow < 1 || p.longWindow < 1 || p.volWindow < 2)
+        throw std::runtime_error("indicator windows must be positive (vol_window >= 2)");
+    if (p.atrBar < 1) throw std::runtime_error("indicators.atr_bar must be at least 1");
+    if (pp.assets < 1 || pp.block < 1) throw std::runtime_error("portfolio.assets and portfolio.block must be positive");
+    if (p.mode == RUN_AAD && (p.trend != TREND_SMA || p.volSource != VOL_WINDOW || p.chain.enabled || p.risk.enabled
+                               || p.expiry.enabled))
+        throw std::runtime_error("aad mode needs indicators.trend = sma, indicators.vol = window, chain, risk and expiry off");
+
+    std::vector<std::string> unused = cfg.unusedKeys();
+    if (!unused.empty()) throw std::runtime_error("unknown config key: " + unused[0]);
+    return p;
+}
+
+#endif // CONFIG_H
@@ -0,0 +1,116 @@
+#ifndef EVENTQUEUE_H
+#define EVENTQUEUE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include "arena.h"
+
+// Kinds of events the event-driven core processes
+enum EventType {
+    EV_MARKET_DATA   = 0,   // new underlying price
+    EV_TIMER         = 1,   // scheduled callback, e.g. holding-period expiry
+    EV_ORDER_ACK     = 2,   // exchange accepted an order
+    EV_FILL          = 3,   // order executed
+    EV_ORDER_ARRIVAL = 4    // order reached the matching engine
+};
+
+// Timestamped event; times are nanoseconds since the start of the run.
+struct Event {
+    uint64_t time;
+    int type;
+    int strategy;     // strategy type (1..5) for timer/order events
+    double value;     // price for market data and fills
+};
+
+// -------------------------
+// Radix heap
+// Monotone priority queue on 64-bit timestamps: keys pushed must not be
+// earlier than the last key popped, which always holds for simulated
+// time. Bucket b holds keys whose highest bit differing from the last
+// popped key is bit b-1, so push is O(1) and each event is moved between
+// buckets at most 64 times over its life. Every bucket is a fixed array
+// from the arena that can hold all the events ever queued at once, so
+// the queue never allocates; overflowing it throws. Events with equal
+// timestamps pop in FIFO order.
+// -------------------------
+class RadixHeap {
+public:
+    static std::size_t arenaBytes(std::size_t capacity) { return kBuckets * capacity * sizeof(Event) + 64; }
+
+    RadixHeap(Arena& arena, std::size_t capacity)
+        : events_(arena.allocArray<Event>(kBuckets * capacity)), capacity_(capacity),
+          last_(0), size_(0), head0_(0) {
+        for (int b = 0; b < kBuckets; b++) count_[b] = 0;
+    }
+
+    RadixHeap(const RadixHeap&) = delete;
+    RadixHeap& operator=(const RadixHeap&) = delete;
+
+    bool empty() const { return size_ == 0; }
+    std::size_t size() const { return size_; }
+    uint64_t lastKey() const { return last_; }
+
+    void push(const Event& e) {
+        if (size_ == capacity_) throw std::runtime_error("event queue full");
+        int b = bucketOf(e.time);
+        if (b == 0 && count_[0] == capacity_) compact0();
+        bucket(b)[count_[b]++] = e;
+        size_++;
+    }
+
+    // Removes and returns the earliest event; the heap must not be empty.
+    Event pop() {
+        if (head0_ == count_[0]) {
+            count_[0] = 0;
+            head0_ = 0;
+            refill();
+        }
+        size_--;
+        return bucket(0)[head0_++];
+    }
+
+private:
+    static const int kBuckets = 65;
+
+    Event* bucket(int b) { return events_ + (std::size_t)b * capacity_; }
+
+    int bucketOf(uint64_t key) const {
+        return key == last_ ? 0 : 64 - __builtin_clzll(key ^ last_);
+    }
+
+    // Drops the already-popped events from the front of bucket 0.
+    void compact0() {
+        Event* b0 = bucket(0);
+        for (std::size_t i = head0_; i < count_[0]; i++) b0[i - head0_] = b0[i];
+        count_[0] -= head0_;
+        head0_ = 0;
+    }
+
+    // Moves the smallest non-empty bucket down so bucket 0 holds the new
+    // minimum key.
+    void refill() {
+        int b = 1;
+        while (count_[b] == 0) b++;
+        Event* src = bucket(b);
+        std::size_t n = count_[b];
+        uint64_t minKey = src[0].time;
+        for (std::size_t i = 1; i < n; i++)
+            if (src[i].time < minKey) minKey = src[i].time;
+        last_ = minKey;
+        count_[b] = 0;
+        for (std::size_t i = 0; i < n; i++) {
+            int d = bucketOf(src[i].time);
+            bucket(d)[count_[d]++] = src[i];
+        }
+    }
+
+    Event* events_;              // kBuckets arrays of capacity_ events
+    std::size_t capacity_;       // most events queued at once
+    std::size_t count_[kBuckets];
+    uint64_t last_;
+    std::size_t size_;
+    std::size_t head0_;          // next unread event in bucket 0
+};
+
+#endif // EVENTQUEUE_H
@@ -0,0 +1,323 @@
+#ifndef EVENTSIM_H
+#define EVENTSIM_H
+
+#include <chrono>
+#include <cmath>
+#include <random>
+#include "arena.h"
+#include "config.h"
+#include "eventqueue.h"
+#include "indicators.h"
+#include "latency.h"
+#include "simulation.h"
+#include "strategies.h"
+
+struct EventSimResult {
+    double cumulativePnL[6];
+    int tradeCount[6];
+    double fees[6];         // costs paid (costs enabled)
+    double slippage[6];
+    double impact[6];
+    uint64_t events;        // events processed
+    uint64_t simTimeNs;     // simulated time covered
+    double nsPerEvent;      // wall-clock cost per event
+    std::size_t loopAllocs; // heap allocations in the event loop (HFT_COUNT_ALLOCS)
+    RiskStats risk;         // pre-trade checks (risk enabled)
+};
+
+// -------------------------
+// Event-driven simulation
+// Market data arrives at irregular times (Poisson or uniform), each
+// strategy decision becomes an order that is acknowledged and filled via
+// queued events, and holding-period exits are timers scheduled at entry
+// rather than a check on every tick. Each strategy keeps at most one
+// timer queued, so the queue holds a bounded number of events and lives
+// in the arena. Simulated time only advances from
+// event to event, so idle periods cost nothing.
+// With the latency model enabled, orders reach the matching engine after
+// the outbound delay; market orders fill there at the prevailing price
+// and limit orders rest at the signal price until their queue clears.
+// -------------------------
+class EventSimulation {
+public:
+    // latencyScale multiplies every configured delay (latency sweeps)
+    EventSimulation(const SimParams& p, SimMemory& mem, uint64_t seed, double latencyScale = 1.0)
+        : p_(p), mem_(mem), generator_((unsigned)seed), normal_(0.0, 1.0),
+          interArrival_(1.0 / p.event.meanIntervalNs), queue_(nullptr), latency_(nullptr), bank_(nullptr),
+          queueModel_(p.latency, seed), ticks_(0), curTick_(0),
+          lastPrice_(p.model.S0), lastTime_(0), seed_(seed), latencyScale_(latencyScale) {
+        for (int k = 0; k < 6; k++) {
+            pending_[k] = nullptr;
+            deadline_[k] = 0;
+            timerQueued_[k] = false;
+        }
+    }
+
+    // Most events queued at once: the next market data, one timer per
+    // strategy and an ack plus a fill for each order in flight (at most
+    // one per strategy, and no more than the order pool holds).
+    static std::size_t queueCapacity(const MemoryConfig& m) {
+        return 1 + 5 + 2 * std::min<std::size_t>(m.orderPoolSize, 5);
+    }
+
+    static std::size_t arenaBytes(const MemoryConfig& m) {
+        return RadixHeap::arenaBytes(queueCapacity(m)) + sizeof(RadixHeap) + 64;
+    }
+
+    EventSimResult run() {
+        std::size_t arenaMark = mem_.arena.mark();
+        queue_ = static_cast<RadixHeap*>(mem_.arena.allocate(sizeof(RadixHeap), alignof(RadixHeap)));
+        new (queue_) RadixHeap(mem_.arena, queueCapacity(p_.memory));
+        prices_ = mem_.arena.allocArray<double>(p_.totalTicks);
+        prices_[0] = p_.model.S0;
+        ticks_ = 1;
+        bank_ = makeStreamingBank(p_, mem_.arena, 1, prices_);
+        book_.risk = makeRiskEngine(p_, mem_.arena, prices_[0]);
+        if (p_.latency.enabled) {
+            latency_ = static_cast<LatencyModel*>(mem_.arena.allocate(sizeof(LatencyModel), alignof(LatencyModel)));
+            new (latency_) LatencyModel(p_.latency, latencyScale_, seed_, mem_.arena);
+        }
+        scheduleNextMarketData(0);
+
+        uint64_t events = 0;
+        std::size_t allocsBeforeLoop = heapAllocCount().load();
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        while (!queue_->empty()) {
+            Event e = queue_->pop();
+            events++;
+            switch (e.type) {
+            case EV_MARKET_DATA: onMarketData(e); break;
+            case EV_TIMER:       onTimer(e); break;
+            case EV_ORDER_ACK:   break;   // strategies act on fills, not acks
+            case EV_FILL:        onFill(e); break;
+            case EV_ORDER_ARRIVAL: onOrderArrival(e); break;
+            }
+        }
+        double elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        std::size_t loopAllocs = heapAllocCount().load() - allocsBeforeLoop;
+
+        EventSimResult r;
+        for (int k = 0; k < 6; k++) {
+            r.cumulativePnL[k] = book_.cumulativePnL[k];
+            r.tradeCount[k] = book_.tradeCount[k];
+            r.fees[k] = book_.fees[k];
+            r.slippage[k] = book_.slippage[k];
+            r.impact[k] = book_.impact[k];
+            if (book_.active[k]) mem_.trades.release(book_.active[k]);
+            if (pending_[k]) mem_.orders.release(pending_[k]);
+        }
+        r.events = events;
+        r.simTimeNs = lastTime_;
+        r.nsPerEvent = events ? elapsed / events : 0.0;
+        r.loopAllocs = loopAllocs;
+        r.risk = riskStats(book_.risk);
+        mem_.arena.rewind(arenaMark);
+        return r;
+    }
+
+private:
+    void scheduleNextMarketData(uint64_t now) {
+        if (ticks_ >= p_.totalTicks) return;
+        double gap = p_.event.poisson ? interArrival_(generator_) : p_.event.meanIntervalNs;
+        uint64_t step = gap < 1.0 ? 1 : (uint64_t)gap;
+        Event e;
+        e.time = now + step;
+        e.type = EV_MARKET_DATA;
+        e.strategy = 0;
+        // GBM over the elapsed time, measured in model time steps
+        ModelParams m = p_.model;
+        m.dt = p_.model.dt * (double)step / p_.event.meanIntervalNs;
+        e.value = gbmStep(m, prices_[ticks_ - 1], normal_(generator_));
+        prices_[ticks_++] = e.value;
+        queue_->push(e);
+    }
+
+    void onMarketData(const Event& e) {
+        lastTime_ = e.time;
+        int t = curTick_ = ticks_ - 1;   // index of this observation
+        // Orders from here on are priced at e.value: centre the band on the
+        // price before it
+        if (book_.risk) book_.risk->onMarket(lastPrice_);
+        lastPrice_ = e.value;
+        scheduleNextMarketData(e.time);
+
+        if (bank_) bank_->update(&prices_[t]);
+        double shortMA, longMA;
+        if (p_.trend != TREND_SMA) {
+            shortMA = trendLine(p_, *bank_)[0];
+            longMA  = trendLine(p_, *bank_)[1];
+        } else {
+            shortMA = computeMA(prices_, t, p_.shortWindow);
+            longMA  = computeMA(prices_, t, p_.longWindow);
+        }
+        double volatility = p_.volSource != VOL_WINDOW ? streamedVol(p_, *bank_)[0]
+                                                       : computeVolatility(prices_, t, p_.volWindow, mem_.arena);
+        int alpha[6];
+        generateSignals(p_, shortMA, longMA, volatility, alpha);
+
+        if (latency_) workRestingOrders(e.time);
+        for (int k = 1; k <= 5; k++) {
+            if (pending_[k]) continue;   // one order in flight per strategy
+            if (!book_.active[k] && alpha[k] == +1) sendOrder(k, +1, e.time);
+            else if (book_.active[k] && alpha[k] == -1) sendOrder(k, -1, e.time);
+        }
+    }
+
+    // Queues the holding timer of strategy k unless one is already queued;
+    // that one fires no later and re-arms itself for deadline_[k].
+    void armTimer(int k, uint64_t time) {
+        if (timerQueued_[k]) return;
+        Event timer;
+        timer.time = time;
+        timer.type = EV_TIMER;
+        timer.strategy = k;
+        timer.value = 0.0;
+        queue_->push(timer);
+        timerQueued_[k] = true;
+    }
+
+    // Holding-period expiry. A timer left over from a trade that already
+    // closed is ignored when flat, or re-armed for the live trade's deadline.
+    void onTimer(const Event& e) {
+        lastTime_ = e.time;
+        int k = e.strategy;
+        timerQueued_[k] = false;
+        if (!book_.active[k] || pending_[k]) return;
+        if (e.time < deadline_[k]) {
+            armTimer(k, deadline_[k]);
+            return;
+        }
+        // Exit rejected by the risk checks: try again a market-data interval later
+        if (!sendOrder(k, -1, e.time))
+            armTimer(k, e.time + (uint64_t)std::max(p_.event.meanIntervalNs, 1.0));
+    }
+
+    // Returns false when the risk checks reject the order
+    bool sendOrder(int k, int side, uint64_t now) {
+        if (book_.risk && !book_.risk->approve(k, side, orderContracts(p_, k), lastPrice_)) return false;
+        Order* o = mem_.orders.acquire();
+        o->strategyType = k;
+        o->tick = curTick_;
+        o->side = side;
+        o->price = lastPrice_;
+        o->volume = p_.strategy[k].volume;
+        pending_[k] = o;
+
+        Event ev;
+        ev.strategy = k;
+        ev.value = lastPrice_;
+        if (!latency_) {
+            // Zero latency: acknowledged and filled at the signal price
+            ev.time = now;
+            ev.type = EV_ORDER_ACK;
+            queue_->push(ev);
+            ev.type = EV_FILL;
+            queue_->push(ev);
+            return true;
+        }
+        ev.time = now + latency_->outbound();
+        ev.type = EV_ORDER_ARRIVAL;
+        queue_->push(ev);
+        return true;
+    }
+
+    // The matching engine receives the order: market orders execute at the
+    // price prevailing now, limit orders join the queue at their price.
+    void onOrderArrival(const Event& e) {
+        lastTime_ = e.time;
+        Order* o = pending_[e.strategy];
+        o->arrivalNs = e.time;
+
+        Event ack = e;
+        ack.time = e.time + latency_->inbound();
+        ack.type = EV_ORDER_ACK;
+        queue_->push(ack);
+
+        if (p_.latency.limitOrders) {
+            o->resting = true;
+            o->queueAhead = queueModel_.joinQueue();
+            return;
+        }
+        Event fill = e;
+        fill.type = EV_FILL;
+        fill.value = lastPrice_;
+        queue_->push(fill);
+    }
+
+    // Each market data event trades through part of the queue ahead of
+    // every resting order; orders resting past the timeout cross instead.
+    void workRestingOrders(uint64_t now) {
+        for (int k = 1; k <= 5; k++) {
+            Order* o = pending_[k];
+            if (!o || !o->resting) continue;
+            o->queueAhead -= queueModel_.tradedVolume();
+            bool timedOut = now - o->arrivalNs >= p_.latency.limitTimeoutNs;
+            if (o->queueAhead > 0.0 && !timedOut) continue;
+            o->resting = false;
+            Event fill;
+            fill.time = now;
+            fill.type = EV_FILL;
+            fill.strategy = k;
+            fill.value = o->queueAhead <= 0.0 ? o->price : lastPrice_;
+            queue_->push(fill);
+        }
+    }
+
+    // The fill price travels in the event.
+    void onFill(const Event& e) {
+        lastTime_ = e.time;
+        int k = e.strategy;
+        Order* o = pending_[k];
+        pending_[k] = nullptr;
+        double S = e.value;
+        Trade*& tr = book_.active[k];
+        if (o->side == +1) {
+            tr = mem_.trades.acquire();
+            tr->open = true;
+            tr->strategyType = k;
+            tr->entryTick = curTick_;
+            tr->entryPrice = S;
+            setStrikes(*tr, S, p_.strategy[k].strikeOffset);
+            tr->volume = o->volume;
+            chargeFill(book_, p_.strategy[k], k, S);
+
+            deadline_[k] = e.time + p_.event.holdTimeNs[k];
+            armTimer(k, deadline_[k]);
+        } else {
+            tr->exitTick = curTick_;
+            tr->exitPrice = S;
+            tr->payoff = tradePayoff(*tr, S) * tr->volume;
+            book_.cumulativePnL[k] += tr->payoff;
+            book_.tradeCount[k]++;
+            chargeFill(book_, p_.strategy[k], k, S);
+            tr->open = false;
+            mem_.trades.release(tr);
+            tr = nullptr;
+        }
+        if (book_.risk) book_.risk->onFill(k, o->side, orderContracts(p_, k), S, book_.cumulativePnL[k]);
+        mem_.orders.release(o);
+    }
+
+    const SimParams& p_;
+    SimMemory& mem_;
+    RadixHeap* queue_;        // arena-backed, built by run()
+    StrategyBook book_;
+    std::default_random_engine generator_;
+    std::normal_distribution<double> normal_;
+    std::exponential_distribution<double> interArrival_;
+    LatencyModel* latency_;   // nullptr when the latency model is off
+    IndicatorBank* bank_;     // streaming indicators, nullptr when none stream
+    QueueModel queueModel_;
+    double* prices_;
+    int ticks_;             // market data observations generated so far
+    int curTick_;           // index of the observation being processed
+    double lastPrice_;
+    uint64_t lastTime_;
+    uint64_t seed_;
+    double latencyScale_;
+    Order* pending_[6];     // order in flight per strategy
+    uint64_t deadline_[6];  // holding-period expiry of the open trade
+    bool timerQueued_[6];   // a holding timer is in the queue
+};
+
+#endif // EVENTSIM_H
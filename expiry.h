@@ -0,0 +1,281 @@
+#ifndef EXPIRY_H
+#define EXPIRY_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include "arena.h"
+#include "config.h"
+#include "strategies.h"
+
+// -------------------------
+// European option values
+// Black-Scholes with the model's per-tick volatility, for cash-settled
+// options; at or past expiry a leg is worth its intrinsic value. A
+// structure's legs follow the payoff functions in strategies.h.
+// -------------------------
+struct OptionLeg {
+    double weight;   // +1 long, -1 short, -2 the butterfly body
+    double strike;
+    bool isCall;
+};
+
+inline int structureLegs(const Trade& tr, OptionLeg legs[3]) {
+    switch (tr.strategyType) {
+    case STRADDLE:
+        legs[0] = OptionLeg{+1.0, tr.strike1, true};
+        legs[1] = OptionLeg{+1.0, tr.strike1, false};
+        return 2;
+    case STRANGLE:
+        legs[0] = OptionLeg{+1.0, tr.strike1, false};
+        legs[1] = OptionLeg{+1.0, tr.strike2, true};
+        return 2;
+    case BULL:
+        legs[0] = OptionLeg{+1.0, tr.strike1, true};
+        legs[1] = OptionLeg{-1.0, tr.strike2, true};
+        return 2;
+    case BEAR:
+        legs[0] = OptionLeg{+1.0, tr.strike1, false};
+        legs[1] = OptionLeg{-1.0, tr.strike2, true};   // bearSpreadPayoff's short leg
+        return 2;
+    case BUTTERFLY:
+        legs[0] = OptionLeg{+1.0, tr.strike1, true};
+        legs[1] = OptionLeg{-2.0, tr.strike2, true};
+        legs[2] = OptionLeg{+1.0, tr.strike3, true};
+        return 3;
+    }
+    return 0;
+}
+
+// Templated on the number type, so aad.h can differentiate it in every input
+template <class T>
+inline T europeanValue(const T& S, const T& K, const T& tau, const T& sigma, const T& rate, bool isCall) {
+    using std::erfc;
+    using std::exp;
+    using std::log;
+    using std::sqrt;
+    if (tau <= 0.0) return isCall ? positivePart(S - K) : positivePart(K - S);
+    const T sd = sigma * sqrt(tau);
+    const T d1 = (log(S / K) + (rate + 0.5 * sigma * sigma) * tau) / sd;
+    const T df = exp(-rate * tau);
+    const T call = 0.5 * (S * erfc(-d1 * M_SQRT1_2) - K * df * erfc(-(d1 - sd) * M_SQRT1_2));
+    return isCall ? call : call - S + K * df;   // put by parity
+}
+
+// Value per unit of volume of the trade's structure with tau to expiry
+inline double structureValue(const Trade& tr, double S, double tau, double sigma, double rate) {
+    OptionLeg legs[3];
+    const int n = structureLegs(tr, legs);
+    double v = 0.0;
+    for (int l = 0; l < n; l++) v += legs[l].weight * europeanValue(S, legs[l].strike, tau, sigma, rate, legs[l].isCall);
+    return v;
+}
+
+struct Greeks {
+    double delta;
+    double gamma;
+    double vega;    // per unit of sigma
+};
+
+// Black-Scholes delta, gamma and vega per unit of volume of the trade's
+// structure with tau to expiry; at expiry, the slope of its payoff and
+// no gamma or vega. Gamma and vega are the same for calls and puts, so
+// every leg shares one density n(d1).
+inline Greeks structureGreeks(const Trade& tr, double S, double tau, double sigma, double rate) {
+    Greeks g = {0.0, 0.0, 0.0};
+    if (tau <= 0.0) {
+        g.delta = tradeDelta(tr, S);
+        return g;
+    }
+    OptionLeg legs[3];
+    const int n = structureLegs(tr, legs);
+    const double sqrtTau = std::sqrt(tau);
+    const double sd = sigma * sqrtTau;
+    for (int l = 0; l < n; l++) {
+        const double d1 = (std::log(S / legs[l].strike) + (rate + 0.5 * sigma * sigma) * tau) / sd;
+        const double pdf = 0.3989422804014327 * std::exp(-0.5 * d1 * d1);
+        g.delta += legs[l].weight * (0.5 * std::erfc(-d1 * M_SQRT1_2) - (legs[l].isCall ? 0.0 : 1.0));
+        g.gamma += legs[l].weight * pdf / (S * sd);
+        g.vega  += legs[l].weight * S * pdf * sqrtTau;
+    }
+    return g;
+}
+
+// -------------------------
+// Expiry wheel
+// Open trades bucketed by expiry tick in a power-of-two ring of slots,
+// each slot an intrusive doubly-linked list through the trades. No listed
+// expiry is further out than the ring is long, so a slot only ever holds
+// trades expiring on one tick: scheduling and early removal are O(1), and
+// collecting a tick's expiries is O(expiring), however many are open.
+// -------------------------
+class ExpiryWheel {
+public:
+    ExpiryWheel(int horizon, Arena& arena) : mask_(slotsFor(horizon) - 1), size_(0) {
+        slots_ = arena.allocArray<Trade*>((std::size_t)mask_ + 1);
+        for (int i = 0; i <= mask_; i++) slots_[i] = nullptr;
+    }
+
+    static std::size_t arenaBytes(int horizon) { return (std::size_t)slotsFor(horizon) * sizeof(Trade*) + 64; }
+
+    // tr->expiryTick must be less than `horizon` ticks away
+    void insert(Trade* tr) {
+        Trade*& head = slots_[tr->expiryTick & mask_];
+        tr->wheelPrev = nullptr;
+        tr->wheelNext = head;
+        if (head) head->wheelPrev = tr;
+        head = tr;
+        size_++;
+    }
+
+    void remove(Trade* tr) {
+        if (tr->wheelPrev) tr->wheelPrev->wheelNext = tr->wheelNext;
+        else slots_[tr->expiryTick & mask_] = tr->wheelNext;
+        if (tr->wheelNext) tr->wheelNext->wheelPrev = tr->wheelPrev;
+        size_--;
+    }
+
+    // Detaches the trades expiring at tick t, linked through wheelNext;
+    // sets count to how many there are
+    Trade* expire(int t, int& count) {
+        Trade*& head = slots_[t & mask_];
+        Trade* due = head;
+        head = nullptr;
+        count = 0;
+        for (Trade* x = due; x; x = x->wheelNext) count++;
+        size_ -= count;
+        return due;
+    }
+
+    int size() const { return size_; }
+
+private:
+    static int slotsFor(int horizon) {
+        int s = 1;
+        while (s < horizon) s <<= 1;
+        return s;
+    }
+
+    Trade** slots_;
+    int mask_;
+    int size_;   // trades scheduled
+};
+
+struct ExpiryStats {
+    uint64_t expired;       // trades settled at expiry
+    uint64_t exercised;     // long legs expiring in the money
+    uint64_t assigned;      // short legs expiring in the money
+    uint64_t worthless;     // legs expiring out of the money
+    int expiryDates;        // ticks on which something expired
+    int maxExpiring;        // most trades expiring on one tick
+    double settled;         // cash settlement paid on expiring structures
+    double premium;         // premium paid for every trade opened
+    double theta[6];        // value lost to time decay, per strategy
+    double openValue[6];    // open positions at model value less premium
+};
+
+// -------------------------
+// Option lifecycle
+// With expiries on, every trade buys its structure at the first listed
+// expiry (a multiple of expiry.cycle ticks) at least expiry.min_ticks
+// away, paying the Black-Scholes premium. An early close sells it back at
+// model value; otherwise at expiry long legs in the money are exercised,
+// short ones assigned, and the structure is cash settled at intrinsic
+// value. Realised PnL is exit value less premium. Open positions are
+// repriced every tick, and the drop in value from one tick less to expiry
+// at the current price is booked as theta.
+// -------------------------
+class OptionLifecycle {
+public:
+    OptionLifecycle(const SimParams& p, Arena& arena)
+        : ep_(p.expiry), sigma_(p.model.sigma), dt_(p.model.dt), wheel_(horizon(p.expiry), arena) {
+        stats_.expired = stats_.exercised = stats_.assigned = stats_.worthless = 0;
+        stats_.expiryDates = stats_.maxExpiring = 0;
+        stats_.settled = stats_.premium = 0.0;
+        for (int k = 0; k < 6; k++) stats_.theta[k] = stats_.openValue[k] = 0.0;
+    }
+
+    static std::size_t arenaBytes(const ExpiryParams& ep) { return ExpiryWheel::arenaBytes(horizon(ep)); }
+
+    // First listed expiry at least minTicks after tick t
+    int listedExpiry(int t) const { return (t + ep_.minTicks + ep_.cycle - 1) / ep_.cycle * ep_.cycle; }
+
+    double value(const Trade& tr, double S, int t) const {
+        return structureValue(tr, S, (tr.expiryTick - t) * dt_, sigma_, ep_.rate);
+    }
+
+    // A trade was opened at tick t, underlying S: buy the structure
+    void open(Trade* tr, int t, double S) {
+        tr->expiryTick = listedExpiry(t);
+        tr->premium = value(*tr, S, t);
+        stats_.premium += tr->premium * tr->volume;
+        wheel_.insert(tr);
+    }
+
+    // Closed before expiry: value received less premium, per unit
+    double close(Trade* tr, int t, double S) {
+        wheel_.remove(tr);
+        return value(*tr, S, t) - tr->premium;
+    }
+
+    // The trades expiring at tick t, linked through wheelNext
+    Trade* expire(int t) {
+        int count;
+        Trade* due = wheel_.expire(t, count);
+        if (count) {
+            stats_.expiryDates++;
+            stats_.maxExpiring = std::max(stats_.maxExpiring, count);
+        }
+        return due;
+    }
+
+    // Exercise, assignment and cash settlement of an expiring trade at S;
+    // returns settlement less premium, per unit
+    double settle(const Trade& tr, double S) {
+        OptionLeg legs[3];
+        const int n = structureLegs(tr, legs);
+        for (int l = 0; l < n; l++) {
+            bool itm = legs[l].isCall ? S > legs[l].strike : S < legs[l].strike;
+            stats_.exercised += itm && legs[l].weight > 0.0;
+            stats_.assigned += itm && legs[l].weight < 0.0;
+            stats_.worthless += !itm;
+        }
+        double cash = tradePayoff(tr, S);
+        stats_.expired++;
+        stats_.settled += cash * tr.volume;
+        return cash - tr.premium;
+    }
+
+    // Theta of the open trades over the tick ending at t, at price S
+    void mark(Trade* const active[6], double S, int t) {
+        for (int k = 1; k <= 5; k++) {
+            const Trade* tr = active[k];
+            if (!tr) continue;
+            double tau = (tr->expiryTick - t) * dt_;
+            double now = structureValue(*tr, S, tau, sigma_, ep_.rate);
+            double before = structureValue(*tr, S, tau + dt_, sigma_, ep_.rate);
+            stats_.theta[k] += (now - before) * tr->volume;
+        }
+    }
+
+    // Adds the model value less premium of open trades at tick t
+    void markOpen(Trade* const active[6], double S, int t) {
+        for (int k = 1; k <= 5; k++)
+            if (active[k]) stats_.openValue[k] += (value(*active[k], S, t) - active[k]->premium) * active[k]->volume;
+    }
+
+    const ExpiryStats& stats() const { return stats_; }
+
+private:
+    // Every listed expiry a new trade can pick is closer than this
+    static int horizon(const ExpiryParams& ep) { return ep.cycle + ep.minTicks + 1; }
+
+    const ExpiryParams& ep_;
+    double sigma_;
+    double dt_;
+    ExpiryWheel wheel_;
+    ExpiryStats stats_;
+};
+
+#endif // EXPIRY_H
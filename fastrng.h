@@ -0,0 +1,23 @@
+#ifndef FASTRNG_H
+#define FASTRNG_H
+
+#include <cstdint>
+
+// Small xorshift generator for per-event noise (quotes, latency jitter,
+// queue depletion); far cheaper than <random>.
+struct XorShift64 {
+    uint64_t s;
+    explicit XorShift64(uint64_t seed) : s(seed ? seed : 0x9E3779B97F4A7C15ull) {}
+    uint64_t next() {
+        s ^= s << 13;
+        s ^= s >> 7;
+        s ^= s << 17;
+        return s;
+    }
+    // Uniform in [0, 1)
+    double uniform() { return (double)(next() >> 11) * (1.0 / 9007199254740992.0); }
+    // Uniform in [-1, 1)
+    double symmetric() { return (double)(int64_t)next() * (1.0 / 9223372036854775808.0); }
+};
+
+#endif // FASTRNG_H
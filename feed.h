@@ -0,0 +1,251 @@
+#ifndef FEED_H
+#define FEED_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "arena.h"
+#include "config.h"
+#include "simulation.h"
+
+// -------------------------
+// Market-data wire format
+// One UDP datagram carries a header and `count` ticks, in host byte order
+// (publisher and handler share the box). Packet sequence numbers are
+// consecutive from 1; a packet with FEED_END marks the end of a replay.
+// The handler decodes in place: the receive buffer is read through these
+// structs without copying.
+// -------------------------
+static const uint32_t kFeedMagic = 0x46544648;   // "HFTF"
+static const int kFeedMaxDatagram = 1472;        // Ethernet MTU less IP/UDP headers
+
+enum FeedFlags { FEED_END = 1 };
+
+struct FeedHeader {
+    uint32_t magic;
+    uint16_t count;      // ticks in this packet
+    uint16_t flags;
+    uint64_t seq;        // packet sequence number
+    uint64_t sendNs;     // publisher's CLOCK_MONOTONIC at send
+    uint64_t firstTick;  // index of the first tick in the replay
+};
+
+struct FeedTick {
+    double price;
+};
+
+static const int kFeedMaxTicks = (kFeedMaxDatagram - (int)sizeof(FeedHeader)) / (int)sizeof(FeedTick);
+
+// Same clock as the publisher's stamp
+inline uint64_t feedClockNs() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Opens a UDP socket bound to the port and, for a multicast group, joined
+// to it on the given interface address
+inline int openFeedSocket(const FeedParams& fp) {
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    if (fd < 0) throw std::runtime_error("cannot create feed socket");
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    int rcvbuf = fp.rcvbufBytes;
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+
+    sockaddr_in addr;
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((uint16_t)fp.port);
+    in_addr group;
+    if (inet_pton(AF_INET, fp.group.c_str(), &group) != 1) {
+        close(fd);
+        throw std::runtime_error("bad feed.group address: " + fp.group);
+    }
+    // Binding to the group itself (or a unicast address) filters out other traffic to the port
+    bool multicast = IN_MULTICAST(ntohl(group.s_addr));
+    addr.sin_addr = group;
+    if (bind(fd, (sockaddr*)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        throw std::runtime_error("cannot bind feed socket to " + fp.group + ":" + std::to_string(fp.port));
+    }
+    if (multicast) {
+        ip_mreq mreq;
+        mreq.imr_multiaddr = group;
+        if (inet_pton(AF_INET, fp.interface.c_str(), &mreq.imr_interface) != 1) {
+            close(fd);
+            throw std::runtime_error("bad feed.interface address: " + fp.interface);
+        }
+        if (setsockopt(fd, IPPROTO_IP, IP_ADD_MEMBERSHIP, &mreq, sizeof(mreq)) != 0) {
+            close(fd);
+            throw std::runtime_error("cannot join multicast group " + fp.group + " on " + fp.interface);
+        }
+    }
+    if (fp.busyPoll) {
+        // Kernel busy polling where permitted; the receive loop spins either way
+        int us = 50;
+        setsockopt(fd, SOL_SOCKET, SO_BUSY_POLL, &us, sizeof(us));
+    } else {
+        timeval tv;
+        tv.tv_sec = fp.idleTimeoutMs / 1000;
+        tv.tv_usec = (fp.idleTimeoutMs % 1000) * 1000;
+        setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    }
+    return fd;
+}
+
+struct FeedResult {
+    SimResult sim;
+    uint64_t packets;
+    uint64_t ticks;
+    uint64_t gaps;            // sequence breaks
+    uint64_t missing;         // packets lost in those breaks
+    uint64_t malformed;       // wrong magic or size
+    uint64_t receiveCalls;    // recvmmsg calls that returned data
+    bool ended;               // saw the publisher's end packet
+    bool full;                // stopped at run.ticks ticks
+    double p50Ns, p99Ns, maxNs, meanNs;   // packet send to signals computed
+};
+
+// -------------------------
+// Feed handler
+// Receives market-data datagrams with recvmmsg, up to feed.batch per call,
+// into arena buffers: blocking with an idle timeout, or with busy_poll
+// spinning on non-blocking calls. Packets are checked for sequence gaps and
+// decoded in place; each tick is appended to the price path and run
+// through the same processTick as the simulation. For every packet the
+// time from the publisher's send stamp to the signals for its last tick is
+// recorded, so the report is packet-to-signal latency on one box.
+// -------------------------
+class FeedHandler {
+public:
+    FeedHandler(const SimParams& p, SimMemory& mem) : p_(p), mem_(mem), fd_(openFeedSocket(p.feed)) {
+        const int batch = p.feed.batch;
+        buffers_ = mem.arena.allocArray<char>((size_t)batch * kFeedMaxDatagram);
+        iov_ = mem.arena.allocArray<iovec>(batch);
+        msgs_ = mem.arena.allocArray<mmsghdr>(batch);
+        for (int i = 0; i < batch; i++) {
+            iov_[i].iov_base = buffers_ + (size_t)i * kFeedMaxDatagram;
+            iov_[i].iov_len = kFeedMaxDatagram;
+            std::memset(&msgs_[i], 0, sizeof(mmsghdr));
+            msgs_[i].msg_hdr.msg_iov = &iov_[i];
+            msgs_[i].msg_hdr.msg_iovlen = 1;
+        }
+        prices_ = mem.arena.allocArray<double>(p.totalTicks);
+        latency_ = mem.arena.allocArray<double>(p.totalTicks);
+    }
+
+    ~FeedHandler() { close(fd_); }
+
+    FeedHandler(const FeedHandler&) = delete;
+    FeedHandler& operator=(const FeedHandler&) = delete;
+
+    static size_t arenaBytes(const SimParams& p) {
+        return (size_t)p.feed.batch * (kFeedMaxDatagram + sizeof(iovec) + sizeof(mmsghdr))
+               + 2 * (size_t)p.totalTicks * sizeof(double) + 8 * 64;
+    }
+
+    FeedResult run() {
+        FeedResult r;
+        std::memset(&r, 0, sizeof(r));
+        StrategyBook book;
+        IndicatorBank* bank = nullptr;
+        int n = 0;                 // ticks on the path so far
+        int timed = 0;             // packets with a latency sample
+        uint64_t expected = 1;     // next packet sequence number
+        int flags = p_.feed.busyPoll ? MSG_DONTWAIT : MSG_WAITFORONE;
+        uint64_t lastData = feedClockNs();
+        const uint64_t idleNs = (uint64_t)p_.feed.idleTimeoutMs * 1000000;
+
+        while (!r.ended && n < p_.totalTicks) {
+            int got = recvmmsg(fd_, msgs_, p_.feed.batch, flags, nullptr);
+            if (got <= 0) {
+                // Nothing waiting (busy poll) or the blocking call timed out
+                if (feedClockNs() - lastData >= idleNs) break;
+                continue;
+            }
+            lastData = feedClockNs();
+            r.receiveCalls++;
+            for (int m = 0; m < got && !r.ended && n < p_.totalTicks; m++) {
+                const FeedHeader* h = reinterpret_cast<const FeedHeader*>(iov_[m].iov_base);
+                size_t len = msgs_[m].msg_len;
+                if (len < sizeof(FeedHeader) || h->magic != kFeedMagic
+                    || len < sizeof(FeedHeader) + (size_t)h->count * sizeof(FeedTick)) {
+                    r.malformed++;
+                    continue;
+                }
+                r.packets++;
+                if (h->seq != expected) {
+                    r.gaps++;
+                    if (h->seq > expected) r.missing += h->seq - expected;
+                }
+                expected = h->seq + 1;
+                if (h->flags & FEED_END) r.ended = true;
+
+                const FeedTick* ticks = reinterpret_cast<const FeedTick*>(h + 1);
+                for (int i = 0; i < h->count && n < p_.totalTicks; i++) {
+                    prices_[n] = ticks[i].price;
+                    if (n == 0) {
+                        // The first tick seeds the path and the streaming state
+                        bank = makeStreamingBank(p_, mem_.arena, 1, prices_);
+                        book.risk = makeRiskEngine(p_, mem_.arena, prices_[0]);
+                    } else {
+                        processTick(p_, book, mem_, prices_, n, nullptr, bank);
+                    }
+                    n++;
+                }
+                if (h->count) latency_[timed++] = (double)(feedClockNs() - h->sendNs);
+                r.ticks += h->count;
+            }
+            // Every datagram slot must be reusable by the next call
+            for (int m = 0; m < got; m++) msgs_[m].msg_len = 0;
+        }
+
+        r.full = n == p_.totalTicks;
+
+        // Latency percentiles over data-carrying packets
+        std::sort(latency_, latency_ + timed);
+        if (timed) {
+            r.p50Ns = latency_[timed / 2];
+            r.p99Ns = latency_[std::min(timed - 1, (int)(0.99 * timed))];
+            r.maxNs = latency_[timed - 1];
+            double sum = 0;
+            for (int i = 0; i < timed; i++) sum += latency_[i];
+            r.meanNs = sum / timed;
+        }
+
+        SimResult& s = r.sim;
+        s.loopAllocs = 0;
+        s.chainNsPerTick = 0.0;
+        s.markNsPerTick = 0.0;
+        s.risk = riskStats(book.risk);
+        for (int i = 0; i < 6; i++) {
+            s.cumulativePnL[i] = book.cumulativePnL[i];
+            s.tradeCount[i] = book.tradeCount[i];
+            s.fees[i] = book.fees[i];
+            s.slippage[i] = book.slippage[i];
+            s.impact[i] = book.impact[i];
+            s.openMark[i] = 0.0;
+            if (book.active[i]) mem_.trades.release(book.active[i]);
+        }
+        return r;
+    }
+
+private:
+    const SimParams& p_;
+    SimMemory& mem_;
+    int fd_;
+    char* buffers_;     // feed.batch datagrams of kFeedMaxDatagram bytes
+    iovec* iov_;
+    mmsghdr* msgs_;
+    double* prices_;    // ticks received so far
+    double* latency_;   // per packet, ns
+};
+
+#endif // FEED_H
@@ -0,0 +1,299 @@
+#ifndef GATEWAY_H
+#define GATEWAY_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <thread>
+#include <vector>
+#include "arena.h"
+#include "config.h"
+#include "simulation.h"
+#include "strategies.h"
+
+// -------------------------
+// Single-producer single-consumer ring
+// Power-of-two capacity, storage from the arena. The producer owns tail_
+// and the consumer head_, each on its own cache line; both keep a cached
+// copy of the other side's index so the shared line is only read when the
+// ring looks full (producer) or empty (consumer).
+// -------------------------
+template <class T>
+class SpscQueue {
+public:
+    SpscQueue(Arena& arena, std::size_t capacity)
+        : slots_(arena.allocArray<T>(capacity)), mask_(capacity - 1),
+          head_(0), tailCache_(0), tail_(0), headCache_(0) {}
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    // Producer side; false when full
+    bool push(const T& v) {
+        std::size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - headCache_ > mask_) {
+            headCache_ = head_.load(std::memory_order_acquire);
+            if (tail - headCache_ > mask_) return false;
+        }
+        slots_[tail & mask_] = v;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side: moves up to max entries into out, returns the count
+    std::size_t popBatch(T* out, std::size_t max) {
+        std::size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tailCache_) {
+            tailCache_ = tail_.load(std::memory_order_acquire);
+            if (head == tailCache_) return 0;
+        }
+        std::size_t n = std::min(max, tailCache_ - head);
+        for (std::size_t i = 0; i < n; i++) out[i] = slots_[(head + i) & mask_];
+        head_.store(head + n, std::memory_order_release);
+        return n;
+    }
+
+    // Entries waiting, as seen from the consumer side
+    std::size_t size() const {
+        return tail_.load(std::memory_order_acquire) - head_.load(std::memory_order_relaxed);
+    }
+
+    static std::size_t arenaBytes(std::size_t capacity) { return capacity * sizeof(T) + 64; }
+
+private:
+    T* slots_;
+    const std::size_t mask_;
+    alignas(64) std::atomic<std::size_t> head_;   // consumer
+    std::size_t tailCache_;
+    alignas(64) std::atomic<std::size_t> tail_;   // producer
+    std::size_t headCache_;
+};
+
+// What a strategy asks the gateway to do
+struct OrderIntent {
+    int strategy;
+    int side;           // +1 open, -1 close
+    int tick;
+    int volume;
+    double price;       // underlying at the decision
+    uint64_t sentNs;    // steady-clock time of publication
+};
+
+// The gateway's answer to an intent, returned on the strategy's ack ring
+struct OrderAck {
+    int tick;
+    int filled;         // 0 when the gateway rejected the intent
+};
+
+struct GatewayStats {
+    uint64_t intents;
+    uint64_t batches;
+    uint64_t rejected;
+    uint64_t producerStalls;   // pushes that found the ring full
+    std::size_t maxDepth;      // deepest ring seen by the gateway
+    double meanQueueNs;        // publication to gateway pickup
+    double maxQueueNs;
+    double ms;                 // wall time with the threads running
+};
+
+// -------------------------
+// Order gateway
+// Market data and signals for the path are computed up front. Then each
+// strategy runs on its own thread, keeps its own view of its position
+// and publishes open and close intents into its own SPSC ring. A single
+// gateway (the calling thread) drains the rings round robin in batches,
+// checks every intent and forwards it to the fill simulator, which fills
+// at the decision price against the one StrategyBook. Only the gateway
+// touches the book and the trade pool, so strategies never contend on
+// them. With risk checks on, intents can be rejected: the gateway then
+// answers each one on a second SPSC ring per strategy, and the strategy
+// waits for that ack before moving its position, as executeStrategies
+// retries a rejected order on the next tick. Without them every intent a
+// strategy publishes fills, so strategies run ahead of the gateway. Either
+// way fills match the per-tick loop and PnL equals single mode. Strikes
+// are not snapped to an option chain, so config rejects chain.enabled.
+// -------------------------
+class OrderGateway {
+public:
+    OrderGateway(const SimParams& p, SimMemory& mem, uint64_t seed) : p_(p), mem_(mem) {
+        const int n = p.totalTicks;
+        prices_ = mem.arena.allocArray<double>(n);
+        signals_ = mem.arena.allocArray<SignalMask>(n);
+        batch_ = mem.arena.allocArray<OrderIntent>(p.gateway.batch);
+        generatePath(p.model, seed, prices_, n);
+        for (int k = 1; k <= 5; k++) {
+            queue_[k] = static_cast<SpscQueue<OrderIntent>*>(
+                mem.arena.allocate(sizeof(SpscQueue<OrderIntent>), alignof(SpscQueue<OrderIntent>)));
+            new (queue_[k]) SpscQueue<OrderIntent>(mem.arena, p.gateway.queueCapacity);
+            acks_[k] = nullptr;
+        }
+
+        // Indicators and signals for every tick, as processTick computes them
+        computeSignals(p, mem, prices_, n, signals_);
+        book_.risk = makeRiskEngine(p, mem.arena, prices_[0]);
+        // One intent in flight per strategy, so its ack ring needs one slot
+        if (book_.risk) {
+            for (int k = 1; k <= 5; k++) {
+                acks_[k] = static_cast<SpscQueue<OrderAck>*>(
+                    mem.arena.allocate(sizeof(SpscQueue<OrderAck>), alignof(SpscQueue<OrderAck>)));
+                new (acks_[k]) SpscQueue<OrderAck>(mem.arena, 1);
+            }
+        }
+    }
+
+    static std::size_t arenaBytes(const SimParams& p) {
+        return (std::size_t)p.totalTicks * (sizeof(double) + sizeof(SignalMask))
+               + (std::size_t)p.gateway.batch * sizeof(OrderIntent)
+               + 5 * (sizeof(SpscQueue<OrderIntent>) + SpscQueue<OrderIntent>::arenaBytes(p.gateway.queueCapacity))
+               + 5 * (sizeof(SpscQueue<OrderAck>) + SpscQueue<OrderAck>::arenaBytes(1))
+               + streamingBankArenaBytes(p, 1) + sizeof(RiskEngine) + 16 * 64;
+    }
+
+    SimResult run(GatewayStats& stats) {
+        for (int k = 0; k < 6; k++) {
+            done_[k].store(0);
+            stalls_[k] = 0;
+        }
+        stats.intents = stats.batches = stats.rejected = 0;
+        stats.maxDepth = 0;
+        stats.maxQueueNs = 0.0;
+        double queueNs = 0.0;
+
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        std::vector<std::thread> strategies;
+        for (int k = 1; k <= 5; k++) strategies.push_back(std::thread(&OrderGateway::strategyLoop, this, k));
+
+        // ----- Gateway: drain every ring round robin until all are done -----
+        int finished = 0;
+        while (finished < 5) {
+            finished = 0;
+            std::size_t drained = 0;
+            for (int k = 1; k <= 5; k++) {
+                bool last = done_[k].load(std::memory_order_acquire) != 0;
+                stats.maxDepth = std::max(stats.maxDepth, queue_[k]->size());
+                std::size_t n = queue_[k]->popBatch(batch_, p_.gateway.batch);
+                if (n) {
+                    stats.batches++;
+                    uint64_t now = nowNs();
+                    for (std::size_t i = 0; i < n; i++) {
+                        double ns = (double)(now - batch_[i].sentNs);
+                        queueNs += ns;
+                        stats.maxQueueNs = std::max(stats.maxQueueNs, ns);
+                        bool filled = accept(batch_[i]);
+                        if (filled) fill(batch_[i]);
+                        else stats.rejected++;
+                        if (acks_[k]) {
+                            OrderAck a;
+                            a.tick = batch_[i].tick;
+                            a.filled = filled;
+                            acks_[k]->push(a);   // the strategy waits on it, so the slot is free
+                        }
+                    }
+                    stats.intents += n;
+                    drained += n;
+                }
+                // Done was read before draining, so an empty ring is final
+                finished += last && n == 0;
+            }
+            if (!drained) std::this_thread::yield();
+        }
+        for (size_t i = 0; i < strategies.size(); i++) strategies[i].join();
+        stats.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        stats.meanQueueNs = stats.intents ? queueNs / stats.intents : 0.0;
+        stats.producerStalls = 0;
+        for (int k = 1; k <= 5; k++) stats.producerStalls += stalls_[k];
+
+        SimResult r;
+        r.loopAllocs = 0;
+        r.chainNsPerTick = 0.0;
+        r.markNsPerTick = 0.0;
+        r.risk = riskStats(book_.risk);
+        for (int i = 0; i < 6; i++) {
+            r.cumulativePnL[i] = book_.cumulativePnL[i];
+            r.tradeCount[i] = book_.tradeCount[i];
+            r.fees[i] = book_.fees[i];
+            r.slippage[i] = book_.slippage[i];
+            r.impact[i] = book_.impact[i];
+            r.openMark[i] = 0.0;
+            if (book_.active[i]) mem_.trades.release(book_.active[i]);
+            book_.active[i] = nullptr;
+        }
+        return r;
+    }
+
+private:
+    static uint64_t nowNs() {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // Strategy k over the whole path: the decisions of executeStrategies,
+    // taken on the strategy's own view of its position. With acks, that
+    // view only moves once the gateway has filled the intent.
+    void strategyLoop(int k) {
+        const StrategyParams& sp = p_.strategy[k];
+        bool open = false;
+        int entryTick = 0;
+        uint64_t stalls = 0;
+        for (int t = 1; t < p_.totalTicks; t++) {
+            SignalMask s = signals_[t];
+            int side = 0;
+            if (!open && signalEnter(s, k)) side = +1;
+            else if (open && ((t - entryTick >= sp.holdPeriod) || signalExit(s, k))) side = -1;
+            if (!side) continue;
+            OrderIntent o;
+            o.strategy = k;
+            o.side = side;
+            o.tick = t;
+            o.volume = sp.volume;
+            o.price = prices_[t];
+            o.sentNs = nowNs();
+            while (!queue_[k]->push(o)) {
+                stalls++;
+                std::this_thread::yield();
+            }
+            if (acks_[k]) {
+                OrderAck a;
+                while (!acks_[k]->popBatch(&a, 1)) std::this_thread::yield();
+                if (!a.filled) continue;
+            }
+            open = side > 0;
+            if (open) entryTick = t;
+        }
+        stalls_[k] = stalls;
+        done_[k].store(1, std::memory_order_release);
+    }
+
+    // Gateway-side check: well-formed, consistent with the book (an open
+    // needs a flat strategy and a free trade slot, a close an open trade),
+    // then the pre-trade limits when risk checks are on
+    bool accept(const OrderIntent& o) {
+        if (o.volume <= 0 || !(o.price > 0.0) || !std::isfinite(o.price)) return false;
+        bool consistent = o.side > 0 ? !book_.active[o.strategy] && mem_.trades.inUse() < mem_.trades.capacity()
+                                     : book_.active[o.strategy] != nullptr;
+        if (!consistent || !book_.risk) return consistent;
+        book_.risk->onMarket(prices_[o.tick - 1]);   // the band centre before this tick
+        return book_.risk->approve(o.strategy, o.side, orderContracts(p_, o.strategy), o.price);
+    }
+
+    // Fill simulator: immediate fill at the decision price
+    void fill(const OrderIntent& o) {
+        if (o.side > 0) openTrade(p_, book_, mem_, o.strategy, o.tick, o.price);
+        else closeTrade(p_, book_, mem_, o.strategy, o.tick, o.price);
+    }
+
+    const SimParams& p_;
+    SimMemory& mem_;
+    StrategyBook book_;
+    double* prices_;
+    SignalMask* signals_;
+    OrderIntent* batch_;
+    SpscQueue<OrderIntent>* queue_[6];   // 1..5
+    SpscQueue<OrderAck>* acks_[6];       // 1..5, gateway to strategy; nullptr without risk checks
+    std::atomic<int> done_[6];
+    uint64_t stalls_[6];                 // set by strategy k when it finishes
+};
+
+#endif // GATEWAY_H
@@ -0,0 +1,190 @@
+#ifndef GREEKS_H
+#define GREEKS_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include "arena.h"
+#include "config.h"
+
+// Sum of x[0..n) by pairwise halving: rounding error grows with log n
+// rather than n, at the cost of a plain loop
+inline double pairwiseSum(const double* x, int n) {
+    if (n <= 16) {
+        double s = 0.0;
+        for (int i = 0; i < n; i++) s += x[i];
+        return s;
+    }
+    const int h = n / 2;
+    return pairwiseSum(x, h) + pairwiseSum(x + h, n - h);
+}
+
+enum GreekEstimator {
+    GK_PRICE = 0,
+    GK_DELTA_PW,      // pathwise
+    GK_DELTA_LR,      // likelihood ratio
+    GK_GAMMA_LR,
+    GK_GAMMA_MIXED,   // likelihood ratio applied to the pathwise delta
+    GK_VEGA_PW,
+    GK_VEGA_LR,
+    GK_ESTIMATORS
+};
+
+static const char* const kGreekEstimatorNames[GK_ESTIMATORS] = {
+    "price", "delta (pathwise)", "delta (likelihood ratio)", "gamma (likelihood ratio)",
+    "gamma (mixed)", "vega (pathwise)", "vega (likelihood ratio)"};
+
+// The legs priced: the LSM option exercised at maturity only, and an
+// arithmetic-average (Asian) option on the exercise dates
+enum GreekLeg { LEG_EUROPEAN = 0, LEG_ASIAN, GREEK_LEGS };
+
+struct GreekEstimate {
+    double mean[GK_ESTIMATORS];
+    double stdError[GK_ESTIMATORS];
+};
+
+// Per-path quantities recorded while a path is generated
+enum GreekPathStat { GP_FIRST_Z = 0, GP_SUM_Z, GP_SUM_Z2, GP_SUM_S, GP_SUM_DSDSIGMA, GP_TERMINAL, GP_STATS };
+
+// Black-Scholes delta, gamma and vega, to check the European estimates
+inline void blackScholesGreeks(double S, double K, double T, double sigma, double rate, bool isCall,
+                               double& delta, double& gamma, double& vega) {
+    const double sd = sigma * std::sqrt(T);
+    const double d1 = (std::log(S / K) + (rate + 0.5 * sigma * sigma) * T) / sd;
+    const double pdf = std::exp(-0.5 * d1 * d1) / std::sqrt(2.0 * M_PI);
+    delta = 0.5 * std::erfc(-d1 * M_SQRT1_2) - (isCall ? 0.0 : 1.0);
+    gamma = pdf / (S * sd);
+    vega = S * pdf * std::sqrt(T);
+}
+
+// -------------------------
+// Monte Carlo Greeks
+// Delta, gamma and vega of each leg from the paths the LSM engine already
+// generates: while a path is drawn, its first shock, shock sums, average
+// price and d(average)/d(sigma) are recorded, and once a seed block of
+// paths is complete one branch-free pass over the block turns them into
+// every estimator for both legs:
+//   pathwise          differentiate the discounted payoff along the path
+//                     (delta, vega; not gamma, the payoff kink has no
+//                     second derivative)
+//   likelihood ratio  payoff times the score of the path density in S0
+//                     or sigma (delta, gamma, vega)
+//   mixed gamma       the likelihood ratio applied to the pathwise delta
+// The European leg depends on the terminal price alone, so its likelihood
+// ratios use the terminal shock; the Asian leg's S0 scores come from the
+// first step and its vega score from every step. Each block's values and
+// squares are summed pairwise into per-block totals, and the totals are
+// reduced pairwise in block order after the threads join, so estimates
+// are the same for any thread count.
+// -------------------------
+class McGreeks {
+public:
+    static const int kSeries = GREEK_LEGS * GK_ESTIMATORS;
+
+    McGreeks(const SimParams& p, int blockPaths, int threads, Arena& arena)
+        : lp_(p.lsm), S0_(p.model.S0), sigma_(p.model.sigma), blockPaths_(blockPaths),
+          blocks_((p.lsm.paths + blockPaths - 1) / blockPaths) {
+        stats_ = arena.allocArray<double>((std::size_t)threads * GP_STATS * blockPaths);
+        values_ = arena.allocArray<double>((std::size_t)threads * kSeries * blockPaths);
+        sums_ = arena.allocArray<double>((std::size_t)blocks_ * 2 * kSeries);
+        column_ = arena.allocArray<double>(blocks_);
+    }
+
+    static std::size_t arenaBytes(const LsmParams& lp, int blockPaths) {
+        const std::size_t blocks = (std::size_t)(lp.paths + blockPaths - 1) / blockPaths;
+        return ((std::size_t)lp.threads * (GP_STATS + kSeries) * blockPaths + blocks * (2 * kSeries + 1)) * sizeof(double)
+               + 4 * 64;
+    }
+
+    // Thread t's row for one per-path quantity, indexed by path in block
+    double* stat(int t, int s) { return stats_ + ((std::size_t)t * GP_STATS + s) * blockPaths_; }
+
+    // Turns thread t's m recorded paths into block `block`'s totals
+    void finishBlock(int t, int block, int m) {
+        double* v = values_ + (std::size_t)t * kSeries * blockPaths_;
+        estimate(stat(t, 0), v, m);
+        double* out = sums_ + (std::size_t)block * 2 * kSeries;
+        for (int k = 0; k < kSeries; k++) {
+            double* row = v + (std::size_t)k * blockPaths_;
+            out[k] = pairwiseSum(row, m);
+            for (int i = 0; i < m; i++) row[i] *= row[i];
+            out[kSeries + k] = pairwiseSum(row, m);
+        }
+    }
+
+    // Means and standard errors over all paths, once every block is done
+    void result(GreekEstimate legs[GREEK_LEGS]) {
+        const double n = lp_.paths;
+        for (int k = 0; k < kSeries; k++) {
+            for (int b = 0; b < blocks_; b++) column_[b] = sums_[(std::size_t)b * 2 * kSeries + k];
+            const double mean = pairwiseSum(column_, blocks_) / n;
+            for (int b = 0; b < blocks_; b++) column_[b] = sums_[(std::size_t)b * 2 * kSeries + kSeries + k];
+            const double sq = pairwiseSum(column_, blocks_) / n;
+            GreekEstimate& g = legs[k / GK_ESTIMATORS];
+            g.mean[k % GK_ESTIMATORS] = mean;
+            g.stdError[k % GK_ESTIMATORS] = std::sqrt(std::max(sq - mean * mean, 0.0) / n);
+        }
+    }
+
+private:
+    // Estimators for m paths, rows of blockPaths_ per series
+    void estimate(const double* __restrict st, double* __restrict v, int m) const {
+        const std::size_t bp = (std::size_t)blockPaths_;
+        const double* z1 = st + GP_FIRST_Z * bp;
+        const double* zs = st + GP_SUM_Z * bp;
+        const double* z2 = st + GP_SUM_Z2 * bp;
+        const double* sumS = st + GP_SUM_S * bp;
+        const double* dSum = st + GP_SUM_DSDSIGMA * bp;
+        const double* ST = st + GP_TERMINAL * bp;
+        const int dates = lp_.exerciseDates;
+        const double T = lp_.maturity, dt = T / dates, sig = sigma_, K = lp_.strike;
+        const double sign = lp_.isCall ? 1.0 : -1.0;
+        const double disc = std::exp(-lp_.rate * T);
+        const double sqT = std::sqrt(T), sqdt = std::sqrt(dt);
+        const double invDates = 1.0 / dates, invRootDates = 1.0 / std::sqrt((double)dates);
+        const double invS0 = 1.0 / S0_;
+        double* e = v;                                      // European rows
+        double* a = v + (std::size_t)GK_ESTIMATORS * bp;    // Asian rows
+        for (int i = 0; i < m; i++) {
+            // European: f(S_T), with S_T = S0 exp((r - sigma^2/2) T + sigma sqrt(T) Z)
+            const double Z = zs[i] * invRootDates;
+            const double xE = sign * (ST[i] - K);
+            const double fE = disc * std::max(xE, 0.0);
+            const double dfE = xE > 0.0 ? disc * sign : 0.0;
+            const double deltaE = dfE * ST[i] * invS0;
+            e[GK_PRICE * bp + i] = fE;
+            e[GK_DELTA_PW * bp + i] = deltaE;
+            e[GK_DELTA_LR * bp + i] = fE * Z * invS0 / (sig * sqT);
+            e[GK_GAMMA_LR * bp + i] = fE * (Z * Z - 1.0 - Z * sig * sqT) * invS0 * invS0 / (sig * sig * T);
+            e[GK_GAMMA_MIXED * bp + i] = deltaE * (Z / (sig * sqT) - 1.0) * invS0;
+            e[GK_VEGA_PW * bp + i] = dfE * ST[i] * (sqdt * zs[i] - sig * T);
+            e[GK_VEGA_LR * bp + i] = fE * ((Z * Z - 1.0) / sig - Z * sqT);
+
+            // Asian: f(mean of S_1..S_D)
+            const double A = sumS[i] * invDates;
+            const double xA = sign * (A - K);
+            const double fA = disc * std::max(xA, 0.0);
+            const double dfA = xA > 0.0 ? disc * sign : 0.0;
+            const double deltaA = dfA * A * invS0;
+            a[GK_PRICE * bp + i] = fA;
+            a[GK_DELTA_PW * bp + i] = deltaA;
+            a[GK_DELTA_LR * bp + i] = fA * z1[i] * invS0 / (sig * sqdt);
+            a[GK_GAMMA_LR * bp + i] = fA * (z1[i] * z1[i] - 1.0 - z1[i] * sig * sqdt) * invS0 * invS0 / (sig * sig * dt);
+            a[GK_GAMMA_MIXED * bp + i] = deltaA * (z1[i] / (sig * sqdt) - 1.0) * invS0;
+            a[GK_VEGA_PW * bp + i] = dfA * dSum[i] * invDates;
+            a[GK_VEGA_LR * bp + i] = fA * ((z2[i] - dates) / sig - sqdt * zs[i]);
+        }
+    }
+
+    const LsmParams& lp_;
+    double S0_;
+    double sigma_;
+    int blockPaths_;
+    int blocks_;
+    double* stats_;    // [thread][stat][path in block]
+    double* values_;   // [thread][series][path in block]
+    double* sums_;     // [block][series sums, then sums of squares]
+    double* column_;   // one series across blocks, for the final reduction
+};
+
+#endif // GREEKS_H
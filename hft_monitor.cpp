@@ -0,0 +1,71 @@
+#include <iostream>
+#include <iomanip>
+#include <cstring>
+#include <cstdlib>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "telemetry.h"
+using namespace std;
+
+// -------------------------
+// Telemetry monitor
+// Polls the simulator's shared-memory telemetry region and prints one line
+// per new snapshot until the run finishes.
+//   hft_monitor [name] [poll_ms]
+// -------------------------
+int main(int argc, char** argv) {
+    const char* name = argc > 1 ? argv[1] : "/hft_telemetry";
+    int pollMs = argc > 2 ? atoi(argv[2]) : 200;
+    if (pollMs < 1) pollMs = 1;
+
+    // Wait for the simulator to create the region
+    int fd;
+    while ((fd = shm_open(name, O_RDONLY, 0)) < 0) usleep(pollMs * 1000);
+    void* m = MAP_FAILED;
+    while (true) {
+        off_t size = lseek(fd, 0, SEEK_END);
+        if (size >= (off_t)sizeof(TelemetryRegion)) {
+            m = mmap(nullptr, sizeof(TelemetryRegion), PROT_READ, MAP_SHARED, fd, 0);
+            break;
+        }
+        usleep(pollMs * 1000);
+    }
+    close(fd);
+    if (m == MAP_FAILED) {
+        cerr << "cannot map " << name << endl;
+        return 1;
+    }
+    const TelemetryRegion* r = static_cast<const TelemetryRegion*>(m);
+    while (memcmp(r->magic, "HFTTELE2", 8) != 0) usleep(pollMs * 1000);
+
+    cout << "Monitoring " << name << " (writer pid " << r->writerPid << ")" << endl;
+    cout << fixed << setprecision(2);
+    uint64_t seen = 0;
+    while (true) {
+        bool finished = r->done.load(memory_order_acquire) != 0;
+        TelemetrySnapshot s;
+        if (readTelemetry(r, s) && s.updates != seen) {
+            seen = s.updates;
+            double total = 0, netDelta = 0, netGamma = 0, netVega = 0;
+            int open = 0;
+            for (int k = 1; k <= 5; k++) {
+                total += s.pnl[k];
+                netDelta += s.delta[k];
+                netGamma += s.gamma[k];
+                netVega += s.vega[k];
+                open += s.openVolume[k] != 0;
+            }
+            cout << "path " << s.path + 1 << "/" << s.paths << "  tick " << s.tick << "/" << s.totalTicks
+                 << "  S " << s.price << "  PnL " << total << " [";
+            for (int k = 1; k <= 5; k++) cout << (k > 1 ? " " : "") << s.pnl[k];
+            cout << "]  open " << open << "  delta " << netDelta << "  gamma " << setprecision(4) << netGamma << setprecision(2) << "  vega " << netVega
+                 << "  " << s.nsPerTick << " ns/tick (max " << s.maxNsPerTick << ")" << endl;
+        }
+        if (finished) break;
+        usleep(pollMs * 1000);
+    }
+    cout << "Run finished" << endl;
+    munmap(m, sizeof(TelemetryRegion));
+    return 0;
+}
@@ -0,0 +1,141 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <cstring>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "config.h"
+#include "feed.h"
+#include "simulation.h"
+using namespace std;
+
+// -------------------------
+// Market-data publisher
+// Replays ticks to the simulator's feed handler as UDP datagrams in the
+// feed wire format, using the same config file and --set overrides as the
+// simulator ([feed] address, rate and packing). The ticks come from
+// feed.tick_file (one price per line), or else the GBM path the simulator
+// would generate for run.seed and run.ticks, so a feed run can be checked
+// against single mode.
+//   hft_publisher [config.toml] [--set section.key=value ...] [--write ticks.txt]
+// --write saves the ticks as a tick file instead of sending them.
+// -------------------------
+
+vector<double> loadTicks(const SimParams& p) {
+    vector<double> ticks;
+    if (p.feed.tickFile.empty()) {
+        ticks.resize(p.totalTicks);
+        generatePath(p.model, resolveSeed(p.seed), &ticks[0], p.totalTicks);
+        return ticks;
+    }
+    ifstream in(p.feed.tickFile.c_str());
+    if (!in) throw runtime_error("cannot open tick file " + p.feed.tickFile);
+    string line;
+    while (getline(in, line) && (int)ticks.size() < p.totalTicks) {
+        size_t start = line.find_first_not_of(" \t");
+        if (start == string::npos || line[start] == '#') continue;
+        ticks.push_back(stod(line.substr(start)));
+    }
+    if (ticks.empty()) throw runtime_error("no ticks in " + p.feed.tickFile);
+    return ticks;
+}
+
+int main(int argc, char** argv) {
+    SimParams p;
+    string writePath;
+    try {
+        ConfigFile cfg;
+        vector<string> overrides;
+        for (int i = 1; i < argc; i++) {
+            if (strcmp(argv[i], "--set") == 0 && i + 1 < argc) overrides.push_back(argv[++i]);
+            else if (strcmp(argv[i], "--write") == 0 && i + 1 < argc) writePath = argv[++i];
+            else if (argv[i][0] == '-') {
+                cerr << "usage: " << argv[0] << " [config.toml] [--set section.key=value ...] [--write ticks.txt]" << endl;
+                return argv[i][1] == 'h' ? 0 : 1;
+            } else cfg.load(argv[i]);
+        }
+        for (size_t i = 0; i < overrides.size(); i++) cfg.applyOverride(overrides[i]);
+        p = freezeSimParams(cfg);
+    } catch (const exception& e) {
+        cerr << "config error: " << e.what() << endl;
+        return 1;
+    }
+
+    try {
+        vector<double> ticks = loadTicks(p);
+        if (!writePath.empty()) {
+            ofstream out(writePath.c_str());
+            if (!out) throw runtime_error("cannot write " + writePath);
+            out.precision(17);
+            for (size_t i = 0; i < ticks.size(); i++) out << ticks[i] << "\n";
+            cout << "Wrote " << ticks.size() << " ticks to " << writePath << endl;
+            return 0;
+        }
+
+        const FeedParams& fp = p.feed;
+        int fd = socket(AF_INET, SOCK_DGRAM, 0);
+        if (fd < 0) throw runtime_error("cannot create socket");
+        sockaddr_in dest;
+        memset(&dest, 0, sizeof(dest));
+        dest.sin_family = AF_INET;
+        dest.sin_port = htons((uint16_t)fp.port);
+        if (inet_pton(AF_INET, fp.group.c_str(), &dest.sin_addr) != 1) throw runtime_error("bad feed.group " + fp.group);
+        if (IN_MULTICAST(ntohl(dest.sin_addr.s_addr))) {
+            in_addr iface;
+            if (inet_pton(AF_INET, fp.interface.c_str(), &iface) != 1) throw runtime_error("bad feed.interface " + fp.interface);
+            unsigned char loop = 1, ttl = 1;
+            setsockopt(fd, IPPROTO_IP, IP_MULTICAST_IF, &iface, sizeof(iface));
+            setsockopt(fd, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop));
+            setsockopt(fd, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl));
+        }
+
+        // Packets go out on a fixed schedule; sleep while the next one is
+        // far off, spin when it is close
+        const int perPacket = fp.ticksPerPacket;
+        const double intervalNs = fp.rate > 0.0 ? 1e9 * perPacket / fp.rate : 0.0;
+        alignas(8) char buf[kFeedMaxDatagram];
+        FeedHeader* h = reinterpret_cast<FeedHeader*>(buf);
+        FeedTick* body = reinterpret_cast<FeedTick*>(h + 1);
+        uint64_t seq = 0, sent = 0, dropped = 0;
+        uint64_t start = feedClockNs();
+        const size_t packets = (ticks.size() + perPacket - 1) / perPacket + 1;   // data, then the end packet
+        for (size_t k = 0; k < packets; k++) {
+            size_t first = k * perPacket;
+            bool last = k + 1 == packets;
+            int count = last ? 0 : (int)min((size_t)perPacket, ticks.size() - first);
+            h->magic = kFeedMagic;
+            h->count = (uint16_t)count;
+            h->flags = last ? FEED_END : 0;
+            h->seq = ++seq;
+            h->firstTick = first;
+            for (int i = 0; i < count; i++) body[i].price = ticks[first + i];
+
+            uint64_t due = start + (uint64_t)(intervalNs * (seq - 1));
+            for (uint64_t now = feedClockNs(); now < due; now = feedClockNs())
+                if (due - now > 200000) this_thread::sleep_for(chrono::nanoseconds(due - now - 100000));
+            if (!last && fp.dropEvery > 0 && seq % fp.dropEvery == 0) {
+                dropped++;   // simulated loss, for the handler's gap detection
+                continue;
+            }
+            h->sendNs = feedClockNs();
+            size_t len = sizeof(FeedHeader) + count * sizeof(FeedTick);
+            if (sendto(fd, buf, len, 0, (sockaddr*)&dest, sizeof(dest)) != (ssize_t)len)
+                throw runtime_error("sendto failed");
+            sent++;
+        }
+        double secs = (feedClockNs() - start) / 1e9;
+        cout << "Sent " << ticks.size() << " ticks in " << sent << " packets (" << dropped << " dropped) to "
+             << fp.group << ":" << fp.port << " in " << secs << " s" << endl;
+        close(fd);
+    } catch (const exception& e) {
+        cerr << "error: " << e.what() << endl;
+        return 1;
+    }
+    return 0;
+}
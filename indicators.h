@@ -0,0 +1,558 @@
+#ifndef INDICATORS_H
+#define INDICATORS_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+#include "arena.h"
+
+// -------------------------
+// Indicator functions: Moving Average and Volatility
+// Path is anything indexable by tick: a price array, or a lazy scenario
+// view over one (stress mode). The result has the path's number type, so
+// an array of Adouble (aad.h) is differentiated through.
+// -------------------------
+template <class Path>
+struct PathValue {
+    typedef typename std::decay<decltype(std::declval<const Path&>()[0])>::type type;
+};
+
+template <class Path>
+inline typename PathValue<Path>::type computeMA(const Path& prices, int currentTick, int window) {
+    typedef typename PathValue<Path>::type Real;
+    if (currentTick < window - 1) return prices[currentTick];
+    Real sum = 0;
+    for (int i = currentTick - window + 1; i <= currentTick; i++) {
+        sum += prices[i];
+    }
+    return sum / window;
+}
+
+// The returns buffer is per-tick scratch: it lives in the arena and is
+// rewound before returning.
+template <class Path>
+inline typename PathValue<Path>::type computeVolatility(const Path& prices, int currentTick, int window, Arena& scratch) {
+    typedef typename PathValue<Path>::type Real;
+    using std::log;
+    using std::sqrt;
+    if (currentTick < window) return Real(0.0);
+    std::size_t mark = scratch.mark();
+    Real* returns = scratch.allocArray<Real>(window);
+    int n = 0;
+    for (int i = currentTick - window + 1; i <= currentTick; i++) {
+        if (i == 0) continue;
+        returns[n++] = log(prices[i] / prices[i - 1]);
+    }
+    Real mean = 0;
+    for (int i = 0; i < n; i++) {
+        mean += returns[i];
+    }
+    mean /= n;
+    Real variance = 0;
+    for (int i = 0; i < n; i++) {
+        variance += (returns[i] - mean) * (returns[i] - mean);
+    }
+    variance /= n;
+    scratch.rewind(mark);
+    return sqrt(variance);
+}
+
+// Inverse of the standard normal CDF, by bisection; for setup, not the tick loop
+inline double normalQuantile(double prob) {
+    double lo = -40.0, hi = 40.0;
+    for (int i = 0; i < 200; i++) {
+        double mid = 0.5 * (lo + hi);
+        if (0.5 * std::erfc(-mid * M_SQRT1_2) < prob) lo = mid;
+        else hi = mid;
+    }
+    return 0.5 * (lo + hi);
+}
+
+// -------------------------
+// Rolling quantile
+// The q-quantile of the last `window` values, interpolated linearly
+// between order statistics (q = 0.5 averages the middle two of an even
+// count). The window is split at the quantile across two binary heaps of
+// slot indices into a ring of values: a max-heap of the lower part, sized
+// floor(q (count - 1)) + 1, and a min-heap of the rest. Every slot records
+// its heap position, so the value leaving the window is overwritten in
+// place by the one arriving and sifted, instead of being marked for lazy
+// deletion; a swap of the two tops then restores the split. A push is
+// O(log window) and reading the quantile O(1), with fixed arena storage.
+// -------------------------
+class RollingQuantile {
+public:
+    RollingQuantile(int window, double q, Arena& arena)
+        : window_(window), q_(q), count_(0), next_(0), nLo_(0), nHi_(0) {
+        vals_  = arena.allocArray<double>(window);
+        lo_    = arena.allocArray<int>(window);
+        hi_    = arena.allocArray<int>(window);
+        where_ = arena.allocArray<int>(window);
+    }
+
+    static std::size_t arenaBytes(int window) { return (std::size_t)window * (sizeof(double) + 3 * sizeof(int)) + 4 * 64; }
+
+    void reset() { count_ = next_ = nLo_ = nHi_ = 0; }
+
+    void push(double x) {
+        const int s = next_;
+        next_ = next_ + 1 == window_ ? 0 : next_ + 1;
+        vals_[s] = x;
+        if (count_ == window_) {
+            // s held the oldest value: re-sift it where it sits
+            const int i = where_[s];
+            if (i >= 0) fix<true>(lo_, nLo_, i);
+            else fix<false>(hi_, nHi_, ~i);
+            if (nHi_ && vals_[lo_[0]] > vals_[hi_[0]]) {
+                const int a = lo_[0], b = hi_[0];
+                place<true>(lo_, 0, b);
+                place<false>(hi_, 0, a);
+                siftDown<true>(lo_, nLo_, 0);
+                siftDown<false>(hi_, nHi_, 0);
+            }
+            return;
+        }
+        count_++;
+        if (nLo_ == 0 || x <= vals_[lo_[0]]) pushLo(s);
+        else pushHi(s);
+        const int target = (int)(q_ * (count_ - 1)) + 1;
+        while (nLo_ > target) pushHi(popLo());
+        while (nLo_ < target) pushLo(popHi());
+    }
+
+    // 0 before the first push
+    double value() const {
+        if (count_ == 0) return 0.0;
+        const double h = q_ * (count_ - 1);
+        const double frac = h - std::floor(h);
+        const double v = vals_[lo_[0]];
+        return frac > 0.0 && nHi_ ? v + frac * (vals_[hi_[0]] - v) : v;
+    }
+
+    int count() const { return count_; }
+
+private:
+    // lo_ keeps its largest value on top, hi_ its smallest
+    template <bool Lo> bool above(int a, int b) const { return Lo ? vals_[a] > vals_[b] : vals_[a] < vals_[b]; }
+
+    // Positions in hi_ are recorded complemented, so the sign tells the heap
+    template <bool Lo> void place(int* heap, int i, int s) {
+        heap[i] = s;
+        where_[s] = Lo ? i : ~i;
+    }
+
+    template <bool Lo> void siftUp(int* heap, int i) {
+        const int s = heap[i];
+        while (i > 0) {
+            const int parent = (i - 1) / 2;
+            if (!above<Lo>(s, heap[parent])) break;
+            place<Lo>(heap, i, heap[parent]);
+            i = parent;
+        }
+        place<Lo>(heap, i, s);
+    }
+
+    template <bool Lo> void siftDown(int* heap, int n, int i) {
+        const int s = heap[i];
+        for (;;) {
+            int c = 2 * i + 1;
+            if (c >= n) break;
+            if (c + 1 < n && above<Lo>(heap[c + 1], heap[c])) c++;
+            if (!above<Lo>(heap[c], s)) break;
+            place<Lo>(heap, i, heap[c]);
+            i = c;
+        }
+        place<Lo>(heap, i, s);
+    }
+
+    template <bool Lo> void fix(int* heap, int n, int i) {
+        if (i > 0 && above<Lo>(heap[i], heap[(i - 1) / 2])) siftUp<Lo>(heap, i);
+        else siftDown<Lo>(heap, n, i);
+    }
+
+    void pushLo(int s) {
+        place<true>(lo_, nLo_, s);
+        siftUp<true>(lo_, nLo_++);
+    }
+
+    void pushHi(int s) {
+        place<false>(hi_, nHi_, s);
+        siftUp<false>(hi_, nHi_++);
+    }
+
+    int popLo() {
+        const int s = lo_[0];
+        if (--nLo_) {
+            place<true>(lo_, 0, lo_[nLo_]);
+            siftDown<true>(lo_, nLo_, 0);
+        }
+        return s;
+    }
+
+    int popHi() {
+        const int s = hi_[0];
+        if (--nHi_) {
+            place<false>(hi_, 0, hi_[nHi_]);
+            siftDown<false>(hi_, nHi_, 0);
+        }
+        return s;
+    }
+
+    int window_;
+    double q_;
+    int count_;      // values in the window
+    int next_;       // ring slot the next value goes in
+    int nLo_, nHi_;
+    double* vals_;   // ring of the window's values
+    int* lo_;        // max-heap of slots, the lower part
+    int* hi_;        // min-heap of slots, the upper part
+    int* where_;     // per slot: position in lo_, or ~position in hi_
+};
+
+// -------------------------
+// Streaming indicator bank
+// Indicators with constant cost per tick for many lanes at once, where a
+// lane is one (underlying, lookback n) pair. State is structure-of-arrays
+// over lanes: each update gathers every lane's prices from a ring of
+// recent rows, then runs straight-line arithmetic across the lanes with
+// no data-dependent branches.
+//   EMA      alpha = 2 / (n + 1), seeded with the first price
+//   DEMA     2 EMA - EMA(EMA)
+//   KAMA     Kaufman: the efficiency ratio over n ticks moves the
+//            smoothing between 2/3 and 2/31
+//   RSI      Wilder-smoothed gains and losses; 50 when flat
+//   z-score  Bollinger, (price - mean) / stddev of the last n prices
+//   ATR      Wilder-smoothed true range of synthetic bars of barTicks
+//            ticks, each bar's high and low being its extreme ticks
+// Until a lane has seen n values, averages run over what it has.
+// With setMedians every lane also keeps the rolling median of its last n
+// prices; with setQuantileVol every underlying keeps a robust volatility,
+// a quantile of the absolute one-tick log returns over a window scaled to
+// a standard deviation under normal returns (1.4826 x the median for
+// q = 0.5). Both are RollingQuantiles, O(log n) per lane per tick.
+// With setRegime, every underlying (not lane) also runs a two-state
+// volatility regime filter: an HMM forward filter over one-tick returns,
+// zero-mean Gaussian with a low or a high volatility, switching state with
+// a fixed probability per tick. Each tick moves the high-state probability
+// by Bayes' rule through the likelihood ratio of the two states, one exp
+// per underlying, and the regime volatility is the probability-weighted
+// mix of the two.
+// -------------------------
+class IndicatorBank {
+public:
+    IndicatorBank(int lanes, int underlyings, int maxLookback, int barTicks, Arena& arena)
+        : lanes_(lanes), ld_((lanes + 7) & ~7), underlyings_(underlyings),
+          capacity_(ringCapacity(maxLookback)), barTicks_(barTicks), t_(0), barTick_(0), bars_(0),
+          regimeOn_(false), stay_(1.0), lowVol_(0.0), highVol_(0.0), volRatio_(1.0), curvature_(0.0),
+          medianQ_(nullptr), median_(nullptr), volQ_(nullptr), quantileVol_(nullptr), volScale_(1.0) {
+        const size_t ld = (size_t)ld_;
+        ring_  = arena.allocArray<double>((size_t)capacity_ * underlyings_);
+        under_ = arena.allocArray<int>(ld);
+        look_  = arena.allocArray<int>(ld);
+        alpha_ = arena.allocArray<double>(ld);
+        invN_  = arena.allocArray<double>(ld);
+        ref_   = arena.allocArray<double>(ld);
+        x_     = arena.allocArray<double>(ld);
+        prev_  = arena.allocArray<double>(ld);
+        old_   = arena.allocArray<double>(ld);
+        old1_  = arena.allocArray<double>(ld);
+        live_  = arena.allocArray<double>(ld);
+        ema_   = arena.allocArray<double>(ld);
+        ema2_  = arena.allocArray<double>(ld);
+        dema_  = arena.allocArray<double>(ld);
+        kama_  = arena.allocArray<double>(ld);
+        path_  = arena.allocArray<double>(ld);
+        gain_  = arena.allocArray<double>(ld);
+        loss_  = arena.allocArray<double>(ld);
+        rsi_   = arena.allocArray<double>(ld);
+        sum_   = arena.allocArray<double>(ld);
+        sumSq_ = arena.allocArray<double>(ld);
+        z_     = arena.allocArray<double>(ld);
+        high_  = arena.allocArray<double>(ld);
+        low_   = arena.allocArray<double>(ld);
+        close_ = arena.allocArray<double>(ld);
+        atr_   = arena.allocArray<double>(ld);
+        const size_t ud = (size_t)((underlyings + 7) & ~7);
+        pHigh_     = arena.allocArray<double>(ud);
+        regimeVol_ = arena.allocArray<double>(ud);
+        for (int i = 0; i < ld_; i++) setLane(i, 0, 1);
+    }
+
+    static std::size_t arenaBytes(int lanes, int underlyings, int maxLookback) {
+        std::size_t ld = (std::size_t)((lanes + 7) & ~7), ud = (std::size_t)((underlyings + 7) & ~7);
+        return (std::size_t)ringCapacity(maxLookback) * underlyings * sizeof(double)
+               + ld * (24 * sizeof(double) + 2 * sizeof(int)) + ud * 2 * sizeof(double) + 29 * 64;
+    }
+
+    // Lane i follows `underlying` with lookback n (n <= maxLookback)
+    void setLane(int i, int underlying, int n) {
+        under_[i] = underlying;
+        look_[i] = n;
+        alpha_[i] = 2.0 / (n + 1);
+        invN_[i] = 1.0 / n;
+    }
+
+    // Arena bytes setMedians and setQuantileVol take on top of arenaBytes
+    static std::size_t medianArenaBytes(int lanes, int maxLookback) {
+        return (std::size_t)lanes * (sizeof(RollingQuantile) + RollingQuantile::arenaBytes(maxLookback))
+               + (std::size_t)((lanes + 7) & ~7) * sizeof(double) + 2 * 64;
+    }
+
+    static std::size_t quantileVolArenaBytes(int underlyings, int window) {
+        return (std::size_t)underlyings * (sizeof(RollingQuantile) + RollingQuantile::arenaBytes(window))
+               + (std::size_t)((underlyings + 7) & ~7) * sizeof(double) + 2 * 64;
+    }
+
+    // Turns on rolling medians for every lane, over the lane's lookback;
+    // call after setLane
+    void setMedians(Arena& arena) {
+        medianQ_ = static_cast<RollingQuantile*>(arena.allocate(lanes_ * sizeof(RollingQuantile), alignof(RollingQuantile)));
+        for (int i = 0; i < lanes_; i++) new (&medianQ_[i]) RollingQuantile(look_[i], 0.5, arena);
+        median_ = arena.allocArray<double>((std::size_t)ld_);
+        for (int i = 0; i < ld_; i++) median_[i] = 0.0;
+    }
+
+    // Turns on the robust volatility: the q-quantile of absolute returns
+    // over the last `window` ticks
+    void setQuantileVol(int window, double q, Arena& arena) {
+        volQ_ = static_cast<RollingQuantile*>(arena.allocate(underlyings_ * sizeof(RollingQuantile), alignof(RollingQuantile)));
+        for (int u = 0; u < underlyings_; u++) new (&volQ_[u]) RollingQuantile(window, q, arena);
+        quantileVol_ = arena.allocArray<double>((std::size_t)((underlyings_ + 7) & ~7));
+        volScale_ = 1.0 / normalQuantile(0.5 * (1.0 + q));
+    }
+
+    // Turns on the regime filter: per-tick return volatility lowVol or
+    // highVol, leaving the current state with probability switchProb
+    void setRegime(double lowVol, double highVol, double switchProb) {
+        regimeOn_ = true;
+        stay_ = 1.0 - switchProb;
+        lowVol_ = lowVol;
+        highVol_ = highVol;
+        volRatio_ = lowVol / highVol;
+        curvature_ = 0.5 * (1.0 / (lowVol * lowVol) - 1.0 / (highVol * highVol));
+    }
+
+    // Starts every lane from the first price of each underlying
+    void reset(const double* price) {
+        t_ = 0;
+        barTick_ = 0;
+        bars_ = 0;
+        for (int u = 0; u < underlyings_; u++) ring_[u] = price[u];
+        for (int i = 0; i < ld_; i++) {
+            double x = price[under_[i]];
+            ref_[i] = x;
+            ema_[i] = ema2_[i] = dema_[i] = kama_[i] = x;
+            path_[i] = gain_[i] = loss_[i] = 0.0;
+            rsi_[i] = 50.0;
+            sum_[i] = sumSq_[i] = z_[i] = 0.0;
+            high_[i] = -HUGE_VAL;
+            low_[i] = HUGE_VAL;
+            close_[i] = x;
+            atr_[i] = 0.0;
+        }
+        // Regimes start undecided
+        for (int u = 0; u < underlyings_; u++) {
+            pHigh_[u] = 0.5;
+            regimeVol_[u] = 0.5 * (lowVol_ + highVol_);
+        }
+        if (medianQ_)
+            for (int i = 0; i < lanes_; i++) {
+                medianQ_[i].reset();
+                medianQ_[i].push(price[under_[i]]);
+                median_[i] = price[under_[i]];
+            }
+        if (volQ_)
+            for (int u = 0; u < underlyings_; u++) {
+                volQ_[u].reset();
+                quantileVol_[u] = 0.0;
+            }
+    }
+
+    // Next tick: price[u] for every underlying
+    void update(const double* price) {
+        t_++;
+        const int mask = capacity_ - 1;
+        double* row = ring_ + (std::size_t)(t_ & mask) * underlyings_;
+        for (int u = 0; u < underlyings_; u++) row[u] = price[u];
+
+        // ----- Gather: now, one tick ago, n and n + 1 ticks ago -----
+        // Clamping to tick 0 makes the early sums cover what has been seen.
+        const double* prevRow = ring_ + (std::size_t)((t_ - 1) & mask) * underlyings_;
+        for (int i = 0; i < ld_; i++) {
+            const int u = under_[i], n = look_[i];
+            x_[i] = row[u];
+            prev_[i] = prevRow[u];
+            old_[i] = ring_[(std::size_t)(std::max(t_ - n, 0) & mask) * underlyings_ + u];
+            old1_[i] = ring_[(std::size_t)(std::max(t_ - n - 1, 0) & mask) * underlyings_ + u];
+            live_[i] = (double)(t_ >= n);   // a full window: the oldest price leaves
+        }
+
+        // ----- Kernels across lanes -----
+        emaKernel(ema_, ema2_, dema_, x_, alpha_, ld_);
+        kamaKernel(kama_, path_, x_, prev_, old_, old1_, ld_);
+        rsiKernel(gain_, loss_, rsi_, x_, prev_, invN_, 1.0 / t_, ld_);
+        bollingerKernel(sum_, sumSq_, z_, x_, old_, ref_, live_, invN_, 1.0 / (t_ + 1), ld_);
+        rangeKernel(high_, low_, x_, ld_);
+        if (regimeOn_)
+            regimeKernel(pHigh_, regimeVol_, row, prevRow, stay_, lowVol_, highVol_, volRatio_, curvature_, underlyings_);
+        if (medianQ_)
+            for (int i = 0; i < lanes_; i++) {
+                medianQ_[i].push(x_[i]);
+                median_[i] = medianQ_[i].value();
+            }
+        if (volQ_)
+            for (int u = 0; u < underlyings_; u++) {
+                volQ_[u].push(std::fabs(std::log(row[u] / prevRow[u])));
+                quantileVol_[u] = volQ_[u].value() * volScale_;
+            }
+
+        // ----- Bar close, on the same tick for every lane -----
+        if (++barTick_ < barTicks_) return;
+        barTick_ = 0;
+        bars_++;
+        barKernel(atr_, close_, high_, low_, x_, invN_, 1.0 / bars_, ld_);
+    }
+
+    int lanes() const { return lanes_; }
+    const double* ema() const { return ema_; }
+    const double* dema() const { return dema_; }
+    const double* kama() const { return kama_; }
+    const double* rsi() const { return rsi_; }
+    const double* zscore() const { return z_; }
+    const double* atr() const { return atr_; }
+    // Per underlying: probability of the high-volatility regime, and the
+    // regime volatility per tick
+    const double* regime() const { return pHigh_; }
+    const double* regimeVol() const { return regimeVol_; }
+    // Per lane: rolling median; per underlying: robust volatility per tick
+    const double* median() const { return median_; }
+    const double* quantileVol() const { return quantileVol_; }
+
+private:
+    // Per-family kernels over m lanes; separate functions so the compiler
+    // sees the lanes as independent and vectorizes them.
+    static void emaKernel(double* __restrict ema, double* __restrict ema2, double* __restrict dema,
+                          const double* __restrict x, const double* __restrict alpha, int m) {
+        for (int i = 0; i < m; i++) {
+            ema[i] += alpha[i] * (x[i] - ema[i]);
+            ema2[i] += alpha[i] * (ema[i] - ema2[i]);
+            dema[i] = 2.0 * ema[i] - ema2[i];
+        }
+    }
+
+    static void kamaKernel(double* __restrict kama, double* __restrict path, const double* __restrict x,
+                           const double* __restrict prev, const double* __restrict old,
+                           const double* __restrict old1, int m) {
+        const double fast = 2.0 / 3.0, slow = 2.0 / 31.0;
+        for (int i = 0; i < m; i++) {
+            path[i] += std::fabs(x[i] - prev[i]) - std::fabs(old[i] - old1[i]);
+            double change = std::fabs(x[i] - old[i]);
+            double er = change / std::max(std::max(path[i], change), 1e-300);
+            double sc = er * (fast - slow) + slow;
+            kama[i] += sc * sc * (x[i] - kama[i]);
+        }
+    }
+
+    static void rsiKernel(double* __restrict gain, double* __restrict loss, double* __restrict rsi,
+                          const double* __restrict x, const double* __restrict prev,
+                          const double* __restrict invN, double invDiffs, int m) {
+        for (int i = 0; i < m; i++) {
+            double w = std::max(invDiffs, invN[i]);
+            double d = x[i] - prev[i];
+            gain[i] += w * (std::max(d, 0.0) - gain[i]);
+            loss[i] += w * (std::max(-d, 0.0) - loss[i]);
+            rsi[i] = 50.0 + 50.0 * (gain[i] - loss[i]) / std::max(gain[i] + loss[i], 1e-300);
+        }
+    }
+
+    // Sums are of prices relative to the first one, to limit cancellation
+    static void bollingerKernel(double* __restrict sum, double* __restrict sumSq, double* __restrict z,
+                                const double* __restrict x, const double* __restrict old,
+                                const double* __restrict ref, const double* __restrict live,
+                                const double* __restrict invN, double invSeen, int m) {
+        for (int i = 0; i < m; i++) {
+            double y = x[i] - ref[i], yOld = (old[i] - ref[i]) * live[i];
+            sum[i] += y - yOld;
+            sumSq[i] += y * y - yOld * yOld;
+            double w = std::max(invSeen, invN[i]);
+            double mean = sum[i] * w;
+            double var = std::max(sumSq[i] * w - mean * mean, 0.0);
+            z[i] = var > 0.0 ? (y - mean) / std::sqrt(var) : 0.0;
+        }
+    }
+
+    static void rangeKernel(double* __restrict high, double* __restrict low, const double* __restrict x, int m) {
+        for (int i = 0; i < m; i++) {
+            high[i] = std::max(high[i], x[i]);
+            low[i] = std::min(low[i], x[i]);
+        }
+    }
+
+    static void barKernel(double* __restrict atr, double* __restrict close, double* __restrict high,
+                          double* __restrict low, const double* __restrict x, const double* __restrict invN,
+                          double invBars, int m) {
+        for (int i = 0; i < m; i++) {
+            double tr = std::max(high[i] - low[i], std::max(std::fabs(high[i] - close[i]), std::fabs(low[i] - close[i])));
+            atr[i] += std::max(invBars, invN[i]) * (tr - atr[i]);
+            close[i] = x[i];
+            high[i] = -HUGE_VAL;
+            low[i] = HUGE_VAL;
+        }
+    }
+
+    // Forward step of the two-state filter for m underlyings. The prior
+    // carries the last posterior through the switching probabilities; the
+    // likelihood ratio high/low of return r is
+    //   (lowVol / highVol) exp(r^2 (1/lowVol^2 - 1/highVol^2) / 2),
+    // its exponent capped so a huge return saturates instead of overflowing.
+    static void regimeKernel(double* __restrict pHigh, double* __restrict vol, const double* __restrict x,
+                             const double* __restrict prev, double stay, double lowVol, double highVol,
+                             double volRatio, double curvature, int m) {
+        for (int u = 0; u < m; u++) {
+            double r = x[u] / prev[u] - 1.0;
+            double prior = pHigh[u] * stay + (1.0 - pHigh[u]) * (1.0 - stay);
+            double lr = volRatio * std::exp(std::min(curvature * r * r, 700.0));
+            double post = prior * lr / (prior * lr + (1.0 - prior));
+            pHigh[u] = post;
+            vol[u] = lowVol + post * (highVol - lowVol);
+        }
+    }
+
+    // Power of two holding ticks t - n - 1 .. t for the longest lookback
+    static int ringCapacity(int maxLookback) {
+        int c = 1;
+        while (c < maxLookback + 2) c <<= 1;
+        return c;
+    }
+
+    int lanes_;
+    int ld_;            // lanes padded to a multiple of 8
+    int underlyings_;
+    int capacity_;      // ring rows
+    int barTicks_;
+    int t_;             // ticks since reset
+    int barTick_;       // ticks into the current bar
+    int bars_;          // completed bars
+    double* ring_;      // [tick % capacity][underlying] prices
+    int *under_, *look_;
+    double *alpha_, *invN_, *ref_;
+    double *x_, *prev_, *old_, *old1_, *live_;   // gathered prices for this tick
+    double *ema_, *ema2_, *dema_, *kama_, *path_;
+    double *gain_, *loss_, *rsi_;
+    double *sum_, *sumSq_, *z_;
+    double *high_, *low_, *close_, *atr_;
+    // Regime filter, per underlying
+    bool regimeOn_;
+    double stay_, lowVol_, highVol_, volRatio_, curvature_;
+    double *pHigh_, *regimeVol_;
+    // Rolling quantiles: medians per lane, robust volatility per underlying
+    RollingQuantile* medianQ_;
+    double* median_;
+    RollingQuantile* volQ_;
+    double* quantileVol_;
+    double volScale_;   // quantile of |return| to standard deviation
+};
+
+#endif // INDICATORS_H
@@ -0,0 +1,107 @@
+#ifndef LATENCY_H
+#define LATENCY_H
+
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include "arena.h"
+#include "config.h"
+#include "fastrng.h"
+
+// -------------------------
+// Order latency model
+// Outbound latency is wire + gateway + matching, each a base delay plus
+// jitter from its own distribution; acknowledgements travel back over
+// the wire again. The distributions are sampled once into power-of-two
+// tables at construction, so drawing a latency for an order is one
+// xorshift step and a table load.
+// -------------------------
+class LatencyModel {
+public:
+    static const int kTableSize = 4096;
+
+    // scale multiplies every base delay and jitter (latency sweeps)
+    LatencyModel(const LatencyParams& lp, double scale, uint64_t seed, Arena& arena)
+        : rng_(seed ^ 0xA5A5A5A5DEADBEEFull),
+          outbound_(arena.allocArray<uint64_t>(kTableSize)),
+          inbound_(arena.allocArray<uint64_t>(kTableSize)) {
+        std::mt19937_64 gen(seed);
+        double sumOut = 0;
+        for (int i = 0; i < kTableSize; i++) {
+            double out = sample(lp.wire, gen) + sample(lp.gateway, gen) + sample(lp.matching, gen);
+            double in = sample(lp.wire, gen);
+            outbound_[i] = (uint64_t)(scale * out + 0.5);
+            inbound_[i] = (uint64_t)(scale * in + 0.5);
+            sumOut += outbound_[i];
+        }
+        meanOutbound_ = sumOut / kTableSize;
+    }
+
+    static size_t arenaBytes() { return 2 * kTableSize * sizeof(uint64_t) + 2 * 64; }
+
+    // Order send to arrival at the matching engine
+    uint64_t outbound() { return outbound_[rng_.next() & (kTableSize - 1)]; }
+    // Exchange back to the strategy (acks and fill reports)
+    uint64_t inbound() { return inbound_[rng_.next() & (kTableSize - 1)]; }
+
+    double meanOutbound() const { return meanOutbound_; }
+
+    // Mean of one component's distribution: base plus mean jitter
+    static double meanOf(const LatencyComponent& c) {
+        return c.dist == LAT_FIXED ? c.baseNs : c.baseNs + c.jitterNs;
+    }
+
+private:
+    // Jitter distributions all have mean jitterNs
+    static double sample(const LatencyComponent& c, std::mt19937_64& gen) {
+        switch (c.dist) {
+        case LAT_UNIFORM: {
+            std::uniform_real_distribution<double> d(0.0, 2.0 * c.jitterNs);
+            return c.baseNs + d(gen);
+        }
+        case LAT_EXPONENTIAL: {
+            if (c.jitterNs <= 0.0) return c.baseNs;
+            std::exponential_distribution<double> d(1.0 / c.jitterNs);
+            return c.baseNs + d(gen);
+        }
+        case LAT_LOGNORMAL: {
+            // Unit log-sigma gives the heavy tail seen on real links
+            if (c.jitterNs <= 0.0) return c.baseNs;
+            std::lognormal_distribution<double> d(std::log(c.jitterNs) - 0.5, 1.0);
+            return c.baseNs + d(gen);
+        }
+        }
+        return c.baseNs;
+    }
+
+    XorShift64 rng_;
+    uint64_t* outbound_;
+    uint64_t* inbound_;
+    double meanOutbound_;
+};
+
+// -------------------------
+// Queue position for resting limit orders
+// On arrival an order joins the back of the queue at its price level
+// behind a random displayed depth; each later market data event trades
+// through some volume ahead of it. The order fills once the volume ahead
+// is exhausted.
+// -------------------------
+class QueueModel {
+public:
+    QueueModel(const LatencyParams& lp, uint64_t seed)
+        : rng_(seed ^ 0x5DEECE66Dull), depthMean_(lp.queueDepth), tradeMean_(lp.tradeVolume) {}
+
+    // Volume ahead of a newly arrived order: uniform on [0, 2 * mean depth]
+    double joinQueue() { return 2.0 * depthMean_ * rng_.uniform(); }
+
+    // Volume traded at the level on one market data event (exponential)
+    double tradedVolume() { return -tradeMean_ * std::log(1.0 - rng_.uniform()); }
+
+private:
+    XorShift64 rng_;
+    double depthMean_;
+    double tradeMean_;
+};
+
+#endif // LATENCY_H
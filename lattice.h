@@ -0,0 +1,282 @@
+#ifndef LATTICE_H
+#define LATTICE_H
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include "arena.h"
+#include "config.h"
+#include "strategies.h"
+
+// -------------------------
+// American option lattices
+// Prices a batch of American calls and puts at once. Every array is laid
+// out [node][option] with options contiguous, so each backward-induction
+// step is an inner loop across options with per-option up/down factors,
+// probabilities and discounting: straight-line code the compiler
+// vectorizes. Exercise values are tabulated once per price level, so the
+// induction itself is a multiply-add and a max per node. All buffers come
+// from the arena at construction; pricing allocates nothing.
+// CRR binomial uses u = exp(sigma sqrt(dt)), d = 1/u. The trinomial tree
+// is Boyle's, with u = exp(sigma sqrt(2 dt)) and a middle node. With
+// Richardson extrapolation the price is 2 P(N) - P(N/2), which cancels
+// the leading 1/N error term.
+// -------------------------
+class AmericanLattice {
+public:
+    AmericanLattice(const AmericanParams& ap, int capacity, Arena& arena)
+        : steps_(ap.steps), trinomial_(ap.method == LATTICE_TRINOMIAL), richardson_(ap.richardson),
+          ld_((capacity + 7) & ~7), n_(0) {
+        size_t nodes = (size_t)maxNodes(steps_);
+        value_ = arena.allocArray<double>(nodes * ld_);
+        exercise_ = arena.allocArray<double>(nodes * ld_);
+        S_     = arena.allocArray<double>(ld_);
+        K_     = arena.allocArray<double>(ld_);
+        T_     = arena.allocArray<double>(ld_);
+        sigma_ = arena.allocArray<double>(ld_);
+        rate_  = arena.allocArray<double>(ld_);
+        sign_  = arena.allocArray<double>(ld_);
+        up_    = arena.allocArray<double>(ld_);
+        qu_    = arena.allocArray<double>(ld_);
+        qm_    = arena.allocArray<double>(ld_);
+        qd_    = arena.allocArray<double>(ld_);
+        coarse_ = arena.allocArray<double>(ld_);
+    }
+
+    static size_t arenaBytes(const AmericanParams& ap, int capacity) {
+        size_t ld = (size_t)((capacity + 7) & ~7);
+        return (2 * (size_t)maxNodes(ap.steps) * ld + 11 * ld) * sizeof(double) + 13 * 64;
+    }
+
+    void clear() { n_ = 0; }
+    int size() const { return n_; }
+
+    // Queues an option; T is time to expiry, sigma and rate are per unit
+    // of T. Returns its index in the output of price().
+    int add(double S, double K, double T, double sigma, double rate, bool isCall) {
+        int i = n_++;
+        S_[i] = S;
+        K_[i] = K;
+        T_[i] = T;
+        sigma_[i] = sigma;
+        rate_[i] = rate;
+        sign_[i] = isCall ? 1.0 : -1.0;
+        return i;
+    }
+
+    // Prices every queued option into out[0..size())
+    void price(double* out) {
+        if (n_ == 0) return;
+        if (!richardson_) {
+            induct(steps_, out);
+            return;
+        }
+        induct(steps_, out);
+        induct(steps_ / 2, coarse_);
+        for (int o = 0; o < n_; o++) out[o] = 2.0 * out[o] - coarse_[o];
+    }
+
+private:
+    static int maxNodes(int steps) { return 2 * steps + 1; }
+
+    // One node of every option: discounted continuation value against
+    // early exercise. Separate functions so the compiler sees the lanes as
+    // independent.
+    static void binomialNode(double* __restrict v0, const double* __restrict v1,
+                             const double* __restrict ex, const double* __restrict qu,
+                             const double* __restrict qd, int m) {
+        for (int o = 0; o < m; o++) {
+            double cont = qd[o] * v0[o] + qu[o] * v1[o];
+            v0[o] = cont > ex[o] ? cont : ex[o];
+        }
+    }
+
+    static void trinomialNode(double* __restrict v0, const double* __restrict v1, const double* __restrict v2,
+                              const double* __restrict ex, const double* __restrict qu,
+                              const double* __restrict qm, const double* __restrict qd, int m) {
+        for (int o = 0; o < m; o++) {
+            double cont = qd[o] * v0[o] + qm[o] * v1[o] + qu[o] * v2[o];
+            v0[o] = cont > ex[o] ? cont : ex[o];
+        }
+    }
+
+    // Backward induction over an n-step tree for all queued options
+    void induct(int n, double* out) {
+        // Run whole groups of 8 lanes so the inner loops have no scalar
+        // remainder; spare lanes hold a harmless zero-payoff option.
+        const int m = (n_ + 7) & ~7;
+        for (int o = n_; o < m; o++) {
+            S_[o] = K_[o] = T_[o] = 1.0;
+            sigma_[o] = 0.1;
+            rate_[o] = 0.0;
+            sign_[o] = 0.0;
+        }
+        const size_t ld = (size_t)ld_;
+
+        // Discounted branch probabilities (q = disc x p) and the up factor
+        for (int o = 0; o < m; o++) {
+            double dt = T_[o] / n;
+            double growth = std::exp(rate_[o] * dt);
+            double disc = 1.0 / growth;
+            if (trinomial_) {
+                double h = std::exp(sigma_[o] * std::sqrt(0.5 * dt));
+                double g = std::sqrt(growth);
+                double a = (g - 1.0 / h) / (h - 1.0 / h);
+                double b = (h - g) / (h - 1.0 / h);
+                up_[o] = h * h;
+                qu_[o] = disc * a * a;
+                qd_[o] = disc * b * b;
+                qm_[o] = disc - qu_[o] - qd_[o];
+            } else {
+                up_[o] = std::exp(sigma_[o] * std::sqrt(dt));
+                double p = (growth - 1.0 / up_[o]) / (up_[o] - 1.0 / up_[o]);
+                qu_[o] = disc * p;
+                qd_[o] = disc - qu_[o];
+                qm_[o] = 0.0;
+            }
+        }
+
+        // Exercise value on every price level S u^(l - n), l = 0..2n. Both
+        // trees only ever visit these levels, so node prices are never
+        // recomputed during the induction.
+        for (int o = 0; o < m; o++) {
+            double s = S_[o] * std::pow(up_[o], -(double)n);
+            for (int l = 0; l <= 2 * n; l++) {
+                exercise_[l * ld + o] = sign_[o] * (s - K_[o]);
+                s *= up_[o];
+            }
+        }
+
+        // Terminal layer, then steps n-1..0. Step i has i + 1 (binomial,
+        // node j at level 2j - i + n) or 2i + 1 (trinomial, level j + n - i)
+        // nodes; node j reads nodes j.. of step i + 1, so updating in place
+        // in increasing j never reads an overwritten value.
+        if (trinomial_) {
+            for (int j = 0; j <= 2 * n; j++) terminal(value_ + j * ld, exercise_ + j * ld, m);
+            for (int i = n - 1; i >= 0; i--)
+                for (int j = 0; j <= 2 * i; j++) {
+                    double* v = value_ + j * ld;
+                    trinomialNode(v, v + ld, v + 2 * ld, exercise_ + (size_t)(j + n - i) * ld, qu_, qm_, qd_, m);
+                }
+        } else {
+            for (int j = 0; j <= n; j++) terminal(value_ + j * ld, exercise_ + (size_t)(2 * j) * ld, m);
+            for (int i = n - 1; i >= 0; i--)
+                for (int j = 0; j <= i; j++) {
+                    double* v = value_ + j * ld;
+                    binomialNode(v, v + ld, exercise_ + (size_t)(2 * j - i + n) * ld, qu_, qd_, m);
+                }
+        }
+        for (int o = 0; o < n_; o++) out[o] = value_[o];
+    }
+
+    static void terminal(double* __restrict v, const double* __restrict ex, int m) {
+        for (int o = 0; o < m; o++) v[o] = ex[o] > 0.0 ? ex[o] : 0.0;
+    }
+
+    int steps_;
+    bool trinomial_;
+    bool richardson_;
+    int ld_;        // option stride, padded to a multiple of 8
+    int n_;         // options queued
+    double* value_;     // [node][option] option values
+    double* exercise_;  // [level][option] exercise value at S u^(level - n)
+    double *S_, *K_, *T_, *sigma_, *rate_, *sign_;
+    double *up_, *qu_, *qm_, *qd_;
+    double* coarse_;   // N/2-step prices for Richardson extrapolation
+};
+
+// -------------------------
+// Mark-to-market of open positions
+// Each open trade is decomposed into American legs, expiring when its
+// holding period ends; all legs of all strategies are priced as one
+// lattice batch per tick. The mark is the position's value per contract
+// times volume.
+// -------------------------
+class PositionMarker {
+public:
+    PositionMarker(const SimParams& p, Arena& arena)
+        : p_(p), lattice_(p.american, kMaxLegs, arena), markNs_(0), marks_(0) {
+        for (int k = 0; k < 6; k++) mark[k] = 0.0;
+    }
+
+    static size_t arenaBytes(const AmericanParams& ap) {
+        return AmericanLattice::arenaBytes(ap, kMaxLegs);
+    }
+
+    // Marks every open trade at tick t with the underlying at S
+    void markPositions(Trade* const active[6], int t, double S) {
+        std::chrono::steady_clock::time_point c0 = std::chrono::steady_clock::now();
+        lattice_.clear();
+        int legs = 0;
+        for (int k = 1; k <= 5; k++) {
+            mark[k] = 0.0;
+            const Trade* tr = active[k];
+            if (!tr) continue;
+            // To the listed expiry with expiries on, else the end of the holding period
+            int end = tr->expiryTick ? tr->expiryTick : tr->entryTick + p_.strategy[k].holdPeriod;
+            double T = (double)(end - t) * p_.model.dt;
+            if (T < p_.model.dt) T = p_.model.dt;
+            addLegs(*tr, S, T, legs);
+        }
+        lattice_.price(values_);
+        for (int l = 0; l < legs; l++) mark[legStrategy_[l]] += legWeight_[l] * values_[l];
+        for (int k = 1; k <= 5; k++)
+            if (active[k]) mark[k] *= active[k]->volume;
+        markNs_ += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - c0).count();
+        marks_++;
+    }
+
+    double nsPerMark() const { return marks_ ? markNs_ / marks_ : 0.0; }
+
+    double mark[6];   // value of each strategy's open position, 0 when flat
+
+private:
+    static const int kMaxLegs = 16;   // at most three legs for each of five strategies
+
+    // Legs follow the payoff functions in strategies.h
+    void addLegs(const Trade& tr, double S, double T, int& legs) {
+        const int k = tr.strategyType;
+        switch (k) {
+        case STRADDLE:
+            leg(k, +1.0, S, tr.strike1, T, true, legs);
+            leg(k, +1.0, S, tr.strike1, T, false, legs);
+            break;
+        case STRANGLE:
+            leg(k, +1.0, S, tr.strike1, T, false, legs);
+            leg(k, +1.0, S, tr.strike2, T, true, legs);
+            break;
+        case BULL:
+            leg(k, +1.0, S, tr.strike1, T, true, legs);
+            leg(k, -1.0, S, tr.strike2, T, true, legs);
+            break;
+        case BEAR:
+            leg(k, +1.0, S, tr.strike1, T, false, legs);
+            leg(k, -1.0, S, tr.strike2, T, true, legs);   // bearSpreadPayoff's short leg
+            break;
+        case BUTTERFLY:
+            leg(k, +1.0, S, tr.strike1, T, true, legs);
+            leg(k, -2.0, S, tr.strike2, T, true, legs);
+            leg(k, +1.0, S, tr.strike3, T, true, legs);
+            break;
+        }
+    }
+
+    void leg(int k, double weight, double S, double K, double T, bool isCall, int& legs) {
+        // T = ticks x dt, in the model's time units like sigma and rate
+        lattice_.add(S, K, T, p_.model.sigma, p_.american.rate, isCall);
+        legStrategy_[legs] = k;
+        legWeight_[legs] = weight;
+        legs++;
+    }
+
+    const SimParams& p_;
+    AmericanLattice lattice_;
+    double values_[kMaxLegs];
+    int legStrategy_[kMaxLegs];
+    double legWeight_[kMaxLegs];
+    double markNs_;
+    long marks_;
+};
+
+#endif // LATTICE_H
@@ -0,0 +1,302 @@
+#ifndef LSM_H
+#define LSM_H
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "arena.h"
+#include "config.h"
+#include "greeks.h"
+#include "simulation.h"
+
+struct LsmResult {
+    double price;              // American (Bermudan on the exercise dates)
+    double stdError;
+    double european;           // same paths, exercise at maturity only
+    double europeanStdError;
+    double exercisedFraction;  // paths exercised before maturity
+    GreekEstimate greeks[GREEK_LEGS];   // with lsm.greeks, from the same paths
+    double ms;                 // wall time
+};
+
+// -------------------------
+// Longstaff-Schwartz Monte Carlo
+// Risk-neutral GBM paths are generated at the exercise dates and stored
+// structure-of-arrays, [date][path], so every per-date pass reads one
+// contiguous row. Walking back from maturity, each date regresses the
+// discounted cash flow of in-the-money paths on a polynomial basis in
+// S/K and exercises where intrinsic value beats the fitted continuation
+// value. Paths are split across threads: each accumulates the normal
+// equations for its range in blocks (basis rows for a block, then dot
+// products between rows), the small system is reduced and solved once,
+// and the exercise decision for a date is fused with the accumulation for
+// the one before it, so each date costs one parallel pass.
+// Path blocks have their own seeds, so results do not depend on the
+// thread count. With lsm.greeks the generation pass also feeds McGreeks,
+// block by block, for Monte Carlo Greeks at no extra paths.
+// -------------------------
+class LsmEngine {
+public:
+    static const int kMaxBasis = 8;
+    static const int kBlock = 256;         // paths per accumulation block
+    static const int kSeedBlock = 1024;    // paths per generator seed
+
+    LsmEngine(const SimParams& p, Arena& arena, uint64_t seed)
+        : p_(p), lp_(p.lsm), seed_(seed), n_(p.lsm.paths), dates_(p.lsm.exerciseDates),
+          basis_(p.lsm.basisDegree + 1), threads_(p.lsm.threads) {
+        dt_ = lp_.maturity / dates_;
+        disc_ = std::exp(-lp_.rate * dt_);
+        sign_ = lp_.isCall ? 1.0 : -1.0;
+        paths_ = arena.allocArray<double>((size_t)(dates_ + 1) * n_);
+        cash_ = arena.allocArray<double>(n_);
+        exercised_ = arena.allocArray<unsigned char>(n_);
+        partial_ = arena.allocArray<double>((size_t)threads_ * kStride);
+        greeks_ = nullptr;
+        if (lp_.greeks) {
+            greeks_ = static_cast<McGreeks*>(arena.allocate(sizeof(McGreeks), alignof(McGreeks)));
+            new (greeks_) McGreeks(p, kSeedBlock, threads_, arena);
+        }
+    }
+
+    static size_t arenaBytes(const LsmParams& lp) {
+        return ((size_t)(lp.exerciseDates + 2) * lp.paths + (size_t)lp.threads * kStride) * sizeof(double)
+               + lp.paths + 4 * 64 + (lp.greeks ? McGreeks::arenaBytes(lp, kSeedBlock) + sizeof(McGreeks) : 0);
+    }
+
+    LsmResult run() {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        parallel([this](int t, int lo, int hi) { generate(t, lo, hi); });
+
+        // Maturity: the option pays its intrinsic value
+        const double* last = row(dates_);
+        double euroSum = 0, euroSq = 0;
+        for (int i = 0; i < n_; i++) {
+            cash_[i] = intrinsic(last[i]);
+            exercised_[i] = 0;
+            euroSum += cash_[i];
+            euroSq += cash_[i] * cash_[i];
+        }
+
+        // Dates dates_-1 .. 1: apply the previous date's fit (if any), then
+        // discount one period and accumulate this date's regression
+        double beta[kMaxBasis];
+        int fitted = 0;   // date whose beta is pending, 0 = none
+        for (int d = dates_ - 1; d >= 1; d--) {
+            int apply = fitted;
+            parallel([this, apply, &beta, d](int t, int lo, int hi) {
+                if (apply) exercise(apply, beta, lo, hi);
+                accumulate(t, d, lo, hi);
+            });
+            solve(beta);
+            fitted = d;
+        }
+        if (fitted) parallel([this, fitted, &beta](int, int lo, int hi) { exercise(fitted, beta, lo, hi); });
+
+        // Back to time zero
+        double sum = 0, sq = 0, early = 0;
+        for (int i = 0; i < n_; i++) {
+            double v = cash_[i] * disc_;
+            sum += v;
+            sq += v * v;
+            early += exercised_[i];
+        }
+        LsmResult r;
+        double mean = sum / n_;
+        r.price = std::max(mean, intrinsic(p_.model.S0));
+        r.stdError = std::sqrt(std::max(sq / n_ - mean * mean, 0.0) / n_);
+        double euroDisc = std::pow(disc_, dates_);
+        double euroMean = euroSum / n_;
+        r.european = euroDisc * euroMean;
+        r.europeanStdError = euroDisc * std::sqrt(std::max(euroSq / n_ - euroMean * euroMean, 0.0) / n_);
+        r.exercisedFraction = early / n_;
+        if (greeks_) greeks_->result(r.greeks);
+        r.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        return r;
+    }
+
+private:
+    // Normal equations, basis x basis then basis, padded to a cache line
+    static const int kStride = ((kMaxBasis * kMaxBasis + kMaxBasis) + 7) & ~7;
+
+    double* row(int d) const { return paths_ + (size_t)d * n_; }
+    double intrinsic(double S) const { return std::max(sign_ * (S - lp_.strike), 0.0); }
+
+    // Runs f(thread, lo, hi) over contiguous path ranges aligned to seed
+    // blocks, one range per thread
+    template <class F>
+    void parallel(F f) {
+        int blocks = (n_ + kSeedBlock - 1) / kSeedBlock;
+        int per = (blocks + threads_ - 1) / threads_;
+        std::vector<std::thread> pool;
+        for (int t = 1; t < threads_; t++) {
+            int lo = std::min(n_, t * per * kSeedBlock);
+            int hi = std::min(n_, (t + 1) * per * kSeedBlock);
+            pool.push_back(std::thread(f, t, lo, hi));
+        }
+        f(0, 0, std::min(n_, per * kSeedBlock));   // the calling thread takes the first range
+        for (size_t i = 0; i < pool.size(); i++) pool[i].join();
+    }
+
+    // Risk-neutral GBM at the exercise dates, one generator per seed block;
+    // with Greeks on, each path's shocks are summarised as it is drawn
+    void generate(int t, int lo, int hi) {
+        ModelParams m = p_.model;
+        m.mu = lp_.rate;
+        m.dt = dt_;
+        const double sqdt = std::sqrt(dt_);
+        for (int b0 = lo; b0 < hi; b0 += kSeedBlock) {
+            std::default_random_engine generator((unsigned)(seed_ + b0 / kSeedBlock));
+            std::normal_distribution<double> normal(0.0, 1.0);
+            int b1 = std::min(hi, b0 + kSeedBlock);
+            for (int i = b0; i < b1; i++) {
+                double S = m.S0;
+                paths_[i] = S;
+                double z1 = 0, zSum = 0, z2Sum = 0, sSum = 0, dSum = 0;
+                for (int d = 1; d <= dates_; d++) {
+                    double z = normal(generator);
+                    S = gbmStep(m, S, z);
+                    paths_[(size_t)d * n_ + i] = S;
+                    if (greeks_) {
+                        // dS_d / dsigma = S_d (W_d - sigma t_d)
+                        z1 = d == 1 ? z : z1;
+                        zSum += z;
+                        z2Sum += z * z;
+                        sSum += S;
+                        dSum += S * (sqdt * zSum - m.sigma * d * dt_);
+                    }
+                }
+                if (greeks_) {
+                    const int j = i - b0;
+                    greeks_->stat(t, GP_FIRST_Z)[j] = z1;
+                    greeks_->stat(t, GP_SUM_Z)[j] = zSum;
+                    greeks_->stat(t, GP_SUM_Z2)[j] = z2Sum;
+                    greeks_->stat(t, GP_SUM_S)[j] = sSum;
+                    greeks_->stat(t, GP_SUM_DSDSIGMA)[j] = dSum;
+                    greeks_->stat(t, GP_TERMINAL)[j] = S;
+                }
+            }
+            if (greeks_) greeks_->finishBlock(t, b0 / kSeedBlock, b1 - b0);
+        }
+    }
+
+    // Discounts cash flows to date d and adds this thread's in-the-money
+    // paths to the normal equations, a block of paths at a time
+    void accumulate(int t, int d, int lo, int hi) {
+        const int nb = basis_;
+        const double* S = row(d);
+        double* acc = partial_ + (size_t)t * kStride;
+        for (int k = 0; k < kStride; k++) acc[k] = 0.0;
+        double X[kMaxBasis][kBlock];
+        double y[kBlock];
+        const double invK = 1.0 / lp_.strike;
+        for (int b0 = lo; b0 < hi; b0 += kBlock) {
+            int m = std::min(hi - b0, +kBlock);   // +: a copy, so kBlock needs no definition
+            // Basis rows; out-of-the-money paths get weight 0
+            for (int i = 0; i < m; i++) {
+                double s = S[b0 + i];
+                double itm = sign_ * (s - lp_.strike) > 0.0 ? 1.0 : 0.0;
+                double x = s * invK;
+                double v = itm;
+                for (int k = 0; k < nb; k++) {
+                    X[k][i] = v;
+                    v *= x;
+                }
+                cash_[b0 + i] *= disc_;
+                y[i] = cash_[b0 + i] * itm;
+            }
+            for (int a = 0; a < nb; a++) {
+                for (int c = a; c < nb; c++) {
+                    double dot = 0;
+                    for (int i = 0; i < m; i++) dot += X[a][i] * X[c][i];
+                    acc[a * nb + c] += dot;
+                }
+                double dot = 0;
+                for (int i = 0; i < m; i++) dot += X[a][i] * y[i];
+                acc[kMaxBasis * kMaxBasis + a] += dot;
+            }
+        }
+    }
+
+    // Sums the per-thread normal equations and solves them by Cholesky
+    // (with a tiny ridge for dates with few in-the-money paths)
+    void solve(double* beta) {
+        const int nb = basis_;
+        double A[kMaxBasis][kMaxBasis], b[kMaxBasis];
+        for (int a = 0; a < nb; a++) {
+            b[a] = 0;
+            for (int c = a; c < nb; c++) A[a][c] = 0;
+        }
+        for (int t = 0; t < threads_; t++) {
+            const double* acc = partial_ + (size_t)t * kStride;
+            for (int a = 0; a < nb; a++) {
+                for (int c = a; c < nb; c++) A[a][c] += acc[a * nb + c];
+                b[a] += acc[kMaxBasis * kMaxBasis + a];
+            }
+        }
+        for (int a = 0; a < nb; a++) {
+            A[a][a] += 1e-10 * (A[0][0] + 1.0);
+            for (int c = 0; c < a; c++) A[a][c] = A[c][a];
+        }
+        // In-place Cholesky, lower triangle
+        for (int j = 0; j < nb; j++) {
+            double s = A[j][j];
+            for (int k = 0; k < j; k++) s -= A[j][k] * A[j][k];
+            A[j][j] = std::sqrt(s > 0.0 ? s : 1e-300);
+            for (int i = j + 1; i < nb; i++) {
+                double v = A[i][j];
+                for (int k = 0; k < j; k++) v -= A[i][k] * A[j][k];
+                A[i][j] = v / A[j][j];
+            }
+        }
+        for (int i = 0; i < nb; i++) {
+            double v = b[i];
+            for (int k = 0; k < i; k++) v -= A[i][k] * beta[k];
+            beta[i] = v / A[i][i];
+        }
+        for (int i = nb - 1; i >= 0; i--) {
+            double v = beta[i];
+            for (int k = i + 1; k < nb; k++) v -= A[k][i] * beta[k];
+            beta[i] = v / A[i][i];
+        }
+    }
+
+    // Exercises in-the-money paths at date d where intrinsic value beats
+    // the fitted continuation value
+    void exercise(int d, const double* beta, int lo, int hi) {
+        const int nb = basis_;
+        const double* S = row(d);
+        const double invK = 1.0 / lp_.strike;
+        for (int i = lo; i < hi; i++) {
+            double payoff = sign_ * (S[i] - lp_.strike);
+            double x = S[i] * invK;
+            double cont = beta[nb - 1];
+            for (int k = nb - 2; k >= 0; k--) cont = cont * x + beta[k];
+            bool ex = payoff > 0.0 && payoff > cont;
+            cash_[i] = ex ? payoff : cash_[i];
+            exercised_[i] |= ex;
+        }
+    }
+
+    const SimParams& p_;
+    const LsmParams& lp_;
+    uint64_t seed_;
+    int n_;             // paths
+    int dates_;         // exercise dates after time zero; the last is maturity
+    int basis_;         // polynomial terms
+    int threads_;
+    double dt_;         // model time between exercise dates
+    double disc_;       // one-period discount factor
+    double sign_;       // +1 call, -1 put
+    double* paths_;     // [date][path], date 0 is S0
+    double* cash_;      // cash flow of each path, discounted to the current date
+    unsigned char* exercised_;
+    double* partial_;   // per-thread normal equations
+    McGreeks* greeks_;  // nullptr unless lsm.greeks
+};
+
+#endif // LSM_H
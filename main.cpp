@@ -1,304 +1,634 @@
 #include <iostream>
 #include <vector>
 #include <cmath>
-#include <random>
-#include <chrono>
 #include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include "arena.h"
+#include "config.h"
+#include "eventsim.h"
+#include "lsm.h"
+#include "pathcache.h"
+#include "portfolio.h"
+#include "sharded.h"
+#include "telemetry.h"
+#include "feed.h"
+#include "gateway.h"
+#include "session.h"
+#include "sensitivity.h"
+#include "simulation.h"
+#include "stress.h"
 using namespace std;
 
-// Trade structure for each strategy's open trade
-struct Trade {
-    int strategyType;    // 1: Straddle, 2: Strangle, 3: Bull Spread, 4: Bear Spread, 5: Butterfly Spread
-    int entryTick;
-    int exitTick;
-    double entryPrice;
-    double exitPrice;
-    // For options legs, we use strikes computed at entry.
-    double strike1, strike2, strike3; 
-    int volume;
-    double payoff;
-    bool open;
-};
+// -------------------------
+// Debug allocation counting (build with -DHFT_COUNT_ALLOCS)
+// -------------------------
+#ifdef HFT_COUNT_ALLOCS
+void* operator new(size_t n) {
+    heapAllocCount().fetch_add(1, memory_order_relaxed);
+    if (void* p = malloc(n ? n : 1)) return p;
+    throw bad_alloc();
+}
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+#endif
 
 // -------------------------
-// Option Payoff Functions
-// (Assuming zero premiums for simplicity)
+// Reporting
 // -------------------------
-double straddlePayoff(double S, double K) {
-    double call = max(S - K, 0.0);
-    double put  = max(K - S, 0.0);
-    return call + put;
+void reportSingle(const SimResult& r) {
+    double totalPnL = 0;
+    cout << "Cumulative PnL per Strategy:" << endl;
+    for (int i = 1; i <= 5; i++) {
+        cout << "  Strategy " << i << ": " << r.cumulativePnL[i] << endl;
+        totalPnL += r.cumulativePnL[i];
+    }
+    cout << "Total PnL: " << totalPnL << endl;
+#ifdef HFT_COUNT_ALLOCS
+    cout << "Heap allocations in tick loop: " << r.loopAllocs << endl;
+#endif
 }
 
-double stranglePayoff(double S, double K1, double K2) {
-    double put  = max(K1 - S, 0.0);
-    double call = max(S - K2, 0.0);
-    return put + call;
+// Maps (or first generates) the cached paths for seeds seed.. when the
+// path cache is enabled; returns null otherwise.
+PathCache* openPathCache(const SimParams& p, uint64_t seed, uint64_t paths) {
+    if (!p.cache.enabled) return nullptr;
+    PathCache* cache = new PathCache(p, seed, paths, p.cache.dir);
+    cout << (cache->generated() ? "Path cache written: " : "Path cache hit: ") << cache->file() << endl;
+    return cache;
 }
 
-double bullSpreadPayoff(double S, double K1, double K2) {
-    double longCall  = max(S - K1, 0.0);
-    double shortCall = max(S - K2, 0.0);
-    return longCall - shortCall;
+// Live telemetry region when enabled; null otherwise
+Telemetry* openTelemetry(const SimParams& p) {
+    if (!p.telemetry.enabled) return nullptr;
+    return new Telemetry(p, p.mode == RUN_PATHS ? p.paths : 1);
 }
 
-double bearSpreadPayoff(double S, double K1, double K2) {
-    double longPut  = max(K1 - S, 0.0);
-    double shortPut = max(S - K2, 0.0);
-    return longPut - shortPut;
+// Gross PnL and the costs that turn it into the reported net PnL
+void reportCosts(const double* net, const double* fees, const double* slippage, const double* impact) {
+    cout << "PnL breakdown (gross - fees - spread/slippage - impact = net):" << endl;
+    for (int i = 1; i <= 5; i++) {
+        double gross = net[i] + fees[i] + slippage[i] + impact[i];
+        cout << "  Strategy " << i << " (" << kStrategyNames[i] << "): " << gross << " - " << fees[i] << " - "
+             << slippage[i] << " - " << impact[i] << " = " << net[i] << endl;
+    }
 }
 
-double butterflySpreadPayoff(double S, double K1, double K2, double K3) {
-    double longCall1  = max(S - K1, 0.0);
-    double shortCalls = 2.0 * max(S - K2, 0.0);
-    double longCall2  = max(S - K3, 0.0);
-    return longCall1 - shortCalls + longCall2;
+// Pre-trade check counts, failures by limit and the checks' own cost
+void reportRisk(const RiskStats& r) {
+    cout << "Risk checks: " << r.checks << " orders, " << r.rejected << " rejected, "
+         << r.nsPerCheck << " ns per check" << endl;
+    for (int c = 0; c < RISK_CHECKS; c++)
+        if (r.failed[c]) cout << "  " << kRiskCheckNames[c] << ": " << r.failed[c] << endl;
 }
 
-// -------------------------
-// Indicator functions: Moving Average and Volatility
-// -------------------------
-double computeMA(const vector<double>& prices, int currentTick, int window) {
-    if (currentTick < window - 1) return prices[currentTick];
-    double sum = 0;
-    for (int i = currentTick - window + 1; i <= currentTick; i++) {
-        sum += prices[i];
+// Expiry settlement counts, premium against cash settled, and theta
+void reportExpiry(const ExpiryStats& e) {
+    cout << "Option expiries: " << e.expired << " trades over " << e.expiryDates << " expiry dates (max "
+         << e.maxExpiring << " on one tick); legs " << e.exercised << " exercised, " << e.assigned
+         << " assigned, " << e.worthless << " worthless" << endl;
+    cout << "Premium paid / cash settled: " << e.premium << " / " << e.settled << endl;
+    cout << "Theta and open value less premium:" << endl;
+    for (int i = 1; i <= 5; i++)
+        cout << "  Strategy " << i << " (" << kStrategyNames[i] << "): " << e.theta[i] << " / " << e.openValue[i] << endl;
+}
+
+void runSingle(const SimParams& p, SimMemory& mem, uint64_t seed) {
+    unique_ptr<PathCache> cache(openPathCache(p, seed, 1));
+    unique_ptr<Telemetry> telemetry(openTelemetry(p));
+    SimResult r = runSimulation(p, mem, seed, cache ? cache->path(0) : nullptr, telemetry.get());
+    reportSingle(r);
+    if (p.costs) reportCosts(r.cumulativePnL, r.fees, r.slippage, r.impact);
+    if (p.risk.enabled) reportRisk(r.risk);
+    if (p.chain.enabled) {
+        cout << "Option chain: " << p.chain.strikes * p.chain.expiries << " series, "
+             << r.chainNsPerTick << " ns per tick" << endl;
+    }
+    if (p.expiry.enabled) reportExpiry(r.expiry);
+    if (p.american.enabled) {
+        cout << "Open positions at American lattice value:" << endl;
+        for (int i = 1; i <= 5; i++) cout << "  Strategy " << i << ": " << r.openMark[i] << endl;
+        cout << "Lattice marking (" << (p.american.method == LATTICE_TRINOMIAL ? "trinomial" : "binomial")
+             << ", " << p.american.steps << " steps" << (p.american.richardson ? ", Richardson" : "")
+             << "): " << r.markNsPerTick << " ns per tick" << endl;
     }
-    return sum / window;
 }
 
-double computeVolatility(const vector<double>& prices, int currentTick, int window) {
-    if (currentTick < window) return 0.0;
-    vector<double> returns;
-    for (int i = currentTick - window + 1; i <= currentTick; i++) {
-        if (i == 0) continue;
-        double r = log(prices[i] / prices[i - 1]);
-        returns.push_back(r);
+// Runs p.paths independent paths (seeds seed, seed+1, ...) and reports the
+// mean and standard deviation of each strategy's PnL across paths.
+void runPaths(const SimParams& p, SimMemory& mem, uint64_t seed) {
+    unique_ptr<PathCache> cache(openPathCache(p, seed, p.paths));
+    unique_ptr<Telemetry> telemetry(openTelemetry(p));
+    PnLStats stats[6];
+    double fees[6] = {0}, slippage[6] = {0}, impact[6] = {0};
+    size_t allocs = 0;
+    for (int k = 0; k < p.paths; k++) {
+        if (telemetry) telemetry->beginPath(k);
+        SimResult r = runSimulation(p, mem, seed + k, cache ? cache->path(k) : nullptr, telemetry.get());
+        for (int i = 1; i <= 5; i++) {
+            stats[i].add(r.cumulativePnL[i]);
+            fees[i] += r.fees[i] / p.paths;
+            slippage[i] += r.slippage[i] / p.paths;
+            impact[i] += r.impact[i] / p.paths;
+        }
+        allocs += r.loopAllocs;
     }
-    double mean = 0;
-    for (double r : returns) {
-        mean += r;
+    cout << "PnL over " << p.paths << " paths (mean / stddev):" << endl;
+    for (int i = 1; i <= 5; i++) {
+        cout << "  Strategy " << i << " (" << kStrategyNames[i] << "): "
+             << stats[i].mean << " / " << stats[i].stddev() << endl;
     }
-    mean /= returns.size();
-    double variance = 0;
-    for (double r : returns) {
-        variance += (r - mean) * (r - mean);
+    if (p.costs) {
+        double mean[6];
+        for (int i = 0; i < 6; i++) mean[i] = stats[i].mean;
+        cout << "Mean per path:" << endl;
+        reportCosts(mean, fees, slippage, impact);
     }
-    variance /= returns.size();
-    return sqrt(variance);
+#ifdef HFT_COUNT_ALLOCS
+    cout << "Heap allocations in tick loops: " << allocs << endl;
+#else
+    (void)allocs;
+#endif
 }
 
-// -------------------------
-// Main Simulation
-// -------------------------
-int main(){
-    // Simulation parameters
-    const int totalTicks = 10000;   // total simulation steps (HFT style)
-    const double S0 = 100.0;        // initial underlying price
-    const double mu = 0.0001;       // drift per tick
-    const double sigma = 0.01;      // volatility per tick
-    const double dt = 1.0;          // time step
-    const int holdPeriod = 10;      // holding period (in ticks) for each trade
-
-    // Strategy-specific parameters
-    const double delta = 0.05; // 5% offset for strikes
-    // Indicator windows (in ticks)
-    const int shortWindow = 5;
-    const int longWindow  = 20;
-    const int volWindow   = 5;
-    // Volatility thresholds (arbitrary values for demonstration)
-    const double volThresholdHigh       = 0.01;   // for straddle entry
-    const double volThresholdLow        = 0.005;  // for straddle exit
-    const double volThresholdHighStrangle = 0.012; // for strangle entry
-    const double volThresholdLowStrangle  = 0.007; // for strangle exit
-
-    // Cumulative PnL per strategy (indices 1 to 5)
-    double cumulativePnL[6] = {0, 0, 0, 0, 0, 0};
-
-    // Active trade record for each strategy (only one open trade per strategy)
-    Trade activeTrades[6];
+void runMulti(const SimParams& p, SimMemory& mem, uint64_t seed) {
+    PortfolioResult r = runPortfolio(p, mem, seed);
+    double totalPnL = 0;
+    cout << "Portfolio PnL over " << p.portfolio.assets << " underlyings:" << endl;
+    for (int i = 1; i <= 5; i++) {
+        cout << "  Strategy " << i << " (" << kStrategyNames[i] << "): " << r.cumulativePnL[i]
+             << " (" << r.tradeCount[i] << " trades)" << endl;
+        totalPnL += r.cumulativePnL[i];
+    }
+    cout << "Total PnL: " << totalPnL << endl;
+    cout << "Best / worst underlying: " << r.bestAssetPnL << " / " << r.worstAssetPnL << endl;
+    cout << "Time per tick (all underlyings): " << r.nsPerTick << " ns" << endl;
+    if (p.costs) reportCosts(r.cumulativePnL, r.fees, r.slippage, r.impact);
+    if (p.expiry.enabled) reportExpiry(r.expiry);
+}
+
+void runEvent(const SimParams& p, SimMemory& mem, uint64_t seed) {
+    EventSimulation sim(p, mem, seed);
+    EventSimResult r = sim.run();
+    double totalPnL = 0;
+    cout << "Cumulative PnL per Strategy (event-driven):" << endl;
     for (int i = 1; i <= 5; i++) {
-        activeTrades[i].open = false;
+        cout << "  Strategy " << i << ": " << r.cumulativePnL[i] << " (" << r.tradeCount[i] << " trades)" << endl;
+        totalPnL += r.cumulativePnL[i];
     }
+    cout << "Total PnL: " << totalPnL << endl;
+    cout << "Events: " << r.events << " over " << r.simTimeNs / 1e6 << " ms simulated, "
+         << r.nsPerEvent << " ns per event" << endl;
+    if (p.costs) reportCosts(r.cumulativePnL, r.fees, r.slippage, r.impact);
+    if (p.risk.enabled) reportRisk(r.risk);
+#ifdef HFT_COUNT_ALLOCS
+    cout << "Heap allocations in event loop: " << r.loopAllocs << endl;
+#endif
+}
 
-    vector<double> prices;
-    prices.reserve(totalTicks);
-    prices.push_back(S0);
-
-    // Set up random number generator for GBM simulation
-    unsigned seed = chrono::system_clock::now().time_since_epoch().count();
-    default_random_engine generator(seed);
-    normal_distribution<double> distribution(0.0, 1.0);
-
-    // Main simulation loop
-    for (int t = 1; t < totalTicks; t++) {
-        // ----- Simulate underlying price using GBM -----
-        double Z = distribution(generator);
-        double S_prev = prices.back();
-        double S_new = S_prev * exp((mu - 0.5 * sigma * sigma) * dt + sigma * sqrt(dt) * Z);
-        prices.push_back(S_new);
-
-        // ----- Compute indicators (if enough data) -----
-        double shortMA   = computeMA(prices, t, shortWindow);
-        double longMA    = computeMA(prices, t, longWindow);
-        double volatility = computeVolatility(prices, t, volWindow);
-
-        // ----- Generate alpha signals for each strategy ----- 
-        // +1 means "enter" (or hold long), -1 means "exit"
-        int alphaStraddle  = 0;
-        int alphaStrangle  = 0;
-        int alphaBull      = 0;
-        int alphaBear      = 0;
-        int alphaButterfly = 0;
-
-        // Straddle: long if high volatility, exit if low
-        if (volatility > volThresholdHigh)
-            alphaStraddle = +1;
-        else if (volatility < volThresholdLow)
-            alphaStraddle = -1;
-
-        // Strangle: similar but with its own thresholds
-        if (volatility > volThresholdHighStrangle)
-            alphaStrangle = +1;
-        else if (volatility < volThresholdLowStrangle)
-            alphaStrangle = -1;
-
-        // Bull Spread (calls): if short MA > long MA, expect upward movement
-        if (shortMA > longMA)
-            alphaBull = +1;
-        else
-            alphaBull = -1;
-
-        // Bear Spread (puts): if short MA < long MA, expect downward movement
-        if (shortMA < longMA)
-            alphaBear = +1;
-        else
-            alphaBear = -1;
-
-        // Butterfly Spread (calls): profits from low volatility
-        if (volatility < volThresholdLow)
-            alphaButterfly = +1;
-        else
-            alphaButterfly = -1;
-
-        // ----- Execute trades for each strategy -----
-
-        // Strategy 1: Straddle
-        if (!activeTrades[1].open && alphaStraddle == +1) {
-            // Open a new straddle trade
-            activeTrades[1].open = true;
-            activeTrades[1].strategyType = 1;
-            activeTrades[1].entryTick = t;
-            activeTrades[1].entryPrice = S_new;
-            // For a straddle, we use the entry price as the strike.
-            activeTrades[1].strike1 = S_new;
-            activeTrades[1].volume = 10;
-        } else if (activeTrades[1].open) {
-            // Close if holding period met or exit signal triggered
-            if ((t - activeTrades[1].entryTick >= holdPeriod) || (alphaStraddle == -1)) {
-                activeTrades[1].exitTick = t;
-                activeTrades[1].exitPrice = S_new;
-                double payoff = straddlePayoff(S_new, activeTrades[1].strike1);
-                activeTrades[1].payoff = payoff * activeTrades[1].volume;
-                cumulativePnL[1] += activeTrades[1].payoff;
-                activeTrades[1].open = false;
-            }
+// Reruns the event-driven simulation on the same market path with the
+// latency model scaled so the mean outbound delay matches each budget.
+// With costs on, the last column is the total already taken out of PnL.
+void runLatencySweep(const SimParams& p, SimMemory& mem, uint64_t seed) {
+    const LatencyParams& lp = p.latency;
+    double baseMean = LatencyModel::meanOf(lp.wire) + LatencyModel::meanOf(lp.gateway) + LatencyModel::meanOf(lp.matching);
+    if (baseMean <= 0.0) throw runtime_error("latency sweep needs a non-zero latency model");
+    cout << "PnL by mean outbound latency (" << (lp.limitOrders ? "limit" : "market") << " orders):" << endl;
+    cout << "  budget_ns";
+    for (int i = 1; i <= 5; i++) cout << "  S" << i;
+    cout << "  total";
+    if (p.costs) cout << "  costs";
+    cout << endl;
+    size_t allocs = 0;
+    for (size_t b = 0; b < lp.sweepNs.size(); b++) {
+        EventSimulation sim(p, mem, seed, lp.sweepNs[b] / baseMean);
+        EventSimResult r = sim.run();
+        double totalPnL = 0;
+        cout << "  " << lp.sweepNs[b];
+        for (int i = 1; i <= 5; i++) {
+            cout << "  " << r.cumulativePnL[i];
+            totalPnL += r.cumulativePnL[i];
+        }
+        cout << "  " << totalPnL;
+        if (p.costs) {
+            double costs = 0;
+            for (int i = 1; i <= 5; i++) costs += r.fees[i] + r.slippage[i] + r.impact[i];
+            cout << "  " << costs;
         }
+        cout << endl;
+        allocs += r.loopAllocs;
+    }
+#ifdef HFT_COUNT_ALLOCS
+    cout << "Heap allocations in event loops: " << allocs << endl;
+#else
+    (void)allocs;
+#endif
+}
 
-        // Strategy 2: Strangle
-        if (!activeTrades[2].open && alphaStrangle == +1) {
-            activeTrades[2].open = true;
-            activeTrades[2].strategyType = 2;
-            activeTrades[2].entryTick = t;
-            activeTrades[2].entryPrice = S_new;
-            // For a strangle, use lower and higher strikes around the entry price.
-            activeTrades[2].strike1 = S_new * (1 - delta);
-            activeTrades[2].strike2 = S_new * (1 + delta);
-            activeTrades[2].volume = 10;
-        } else if (activeTrades[2].open) {
-            if ((t - activeTrades[2].entryTick >= holdPeriod) || (alphaStrangle == -1)) {
-                activeTrades[2].exitTick = t;
-                activeTrades[2].exitPrice = S_new;
-                double payoff = stranglePayoff(S_new, activeTrades[2].strike1, activeTrades[2].strike2);
-                activeTrades[2].payoff = payoff * activeTrades[2].volume;
-                cumulativePnL[2] += activeTrades[2].payoff;
-                activeTrades[2].open = false;
-            }
+// Forks sweep.workers processes over every (parameter set, path shard)
+// and reports per-strategy PnL statistics for each parameter set.
+void runSweep(const vector<SimParams>& sets, uint64_t seed) {
+    const SimParams& p = sets[0];
+    // Mapped before the fork so every worker shares the pages
+    vector<unique_ptr<PathCache> > owned;
+    vector<const PathCache*> caches;
+    for (size_t s = 0; s < sets.size(); s++) {
+        owned.push_back(unique_ptr<PathCache>(openPathCache(sets[s], seed, sets[s].paths)));
+        caches.push_back(owned.back().get());
+    }
+    ShardedRunner runner(sets, p.sweep.workers, p.sweep.shardPaths, seed, caches);
+    cout.flush();
+    chrono::steady_clock::time_point start = chrono::steady_clock::now();
+    int failed = runner.run();
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    uint64_t paths = 0;
+    for (size_t s = 0; s < sets.size(); s++) {
+        paths += sets[s].paths;
+        if (p.sweep.param.empty()) cout << "PnL over " << sets[s].paths << " paths";
+        else cout << p.sweep.param << " = " << p.sweep.values[s] << ", " << sets[s].paths << " paths";
+        cout << " (mean / stddev / min / max):" << endl;
+        for (int i = 1; i <= 5; i++) {
+            PnLStats st = runner.merged((int)s, i);
+            cout << "  Strategy " << i << " (" << kStrategyNames[i] << "): " << st.mean << " / "
+                 << st.stddev() << " / " << st.min << " / " << st.max << endl;
         }
+    }
+    cout << paths << " paths in " << runner.shardCount() << " shards on "
+         << p.sweep.workers << " workers: " << seconds << " s";
+    if (failed) cout << " (" << failed << " workers failed; their shards were rerun)";
+    cout << endl;
+}
 
-        // Strategy 3: Bull Spread (calls)
-        if (!activeTrades[3].open && alphaBull == +1) {
-            activeTrades[3].open = true;
-            activeTrades[3].strategyType = 3;
-            activeTrades[3].entryTick = t;
-            activeTrades[3].entryPrice = S_new;
-            // For a bull spread, choose strikes below and above the entry price.
-            activeTrades[3].strike1 = S_new * (1 - delta); // long call
-            activeTrades[3].strike2 = S_new * (1 + delta); // short call
-            activeTrades[3].volume = 10;
-        } else if (activeTrades[3].open) {
-            if ((t - activeTrades[3].entryTick >= holdPeriod) || (alphaBull == -1)) {
-                activeTrades[3].exitTick = t;
-                activeTrades[3].exitPrice = S_new;
-                double payoff = bullSpreadPayoff(S_new, activeTrades[3].strike1, activeTrades[3].strike2);
-                activeTrades[3].payoff = payoff * activeTrades[3].volume;
-                cumulativePnL[3] += activeTrades[3].payoff;
-                activeTrades[3].open = false;
-            }
+// Prices the configured American option by Longstaff-Schwartz regression
+void runLsm(const SimParams& p, SimMemory& mem, uint64_t seed) {
+    const LsmParams& lp = p.lsm;
+    size_t mark = mem.arena.mark();
+    LsmEngine engine(p, mem.arena, seed);
+    LsmResult r = engine.run();
+    mem.arena.rewind(mark);
+    cout << "American " << (lp.isCall ? "call" : "put") << ", strike " << lp.strike << ", maturity " << lp.maturity
+         << " (Longstaff-Schwartz, " << lp.paths << " paths, " << lp.exerciseDates << " exercise dates):" << endl;
+    cout << "  American price: " << r.price << " +/- " << r.stdError << endl;
+    cout << "  European price: " << r.european << " +/- " << r.europeanStdError << endl;
+    cout << "  Early exercise premium: " << r.price - r.european << endl;
+    cout << "  Paths exercised early: " << r.exercisedFraction * 100.0 << "%" << endl;
+    cout << "  Time: " << r.ms << " ms on " << lp.threads << " threads" << endl;
+    if (!lp.greeks) return;
+    double bs[GK_ESTIMATORS] = {0};
+    bs[GK_PRICE] = europeanValue(p.model.S0, lp.strike, lp.maturity, p.model.sigma, lp.rate, lp.isCall);
+    blackScholesGreeks(p.model.S0, lp.strike, lp.maturity, p.model.sigma, lp.rate, lp.isCall,
+                       bs[GK_DELTA_PW], bs[GK_GAMMA_LR], bs[GK_VEGA_PW]);
+    bs[GK_DELTA_LR] = bs[GK_DELTA_PW];
+    bs[GK_GAMMA_MIXED] = bs[GK_GAMMA_LR];
+    bs[GK_VEGA_LR] = bs[GK_VEGA_PW];
+    const char* const legs[GREEK_LEGS] = {"European", "Asian (average of the exercise dates)"};
+    cout << "Monte Carlo Greeks on the same paths (mean +/- std error):" << endl;
+    for (int l = 0; l < GREEK_LEGS; l++) {
+        cout << "  " << legs[l] << (l == LEG_EUROPEAN ? ", Black-Scholes in brackets:" : ":") << endl;
+        for (int k = 0; k < GK_ESTIMATORS; k++) {
+            cout << "    " << kGreekEstimatorNames[k] << ": " << r.greeks[l].mean[k] << " +/- " << r.greeks[l].stdError[k];
+            if (l == LEG_EUROPEAN) cout << " [" << bs[k] << "]";
+            cout << endl;
         }
+    }
+}
 
-        // Strategy 4: Bear Spread (puts)
-        if (!activeTrades[4].open && alphaBear == +1) {
-            activeTrades[4].open = true;
-            activeTrades[4].strategyType = 4;
-            activeTrades[4].entryTick = t;
-            activeTrades[4].entryPrice = S_new;
-            // For a bear spread, use a higher strike for the long put and a lower strike for the short put.
-            activeTrades[4].strike1 = S_new * (1 + delta); // long put strike
-            activeTrades[4].strike2 = S_new * (1 - delta); // short put strike
-            activeTrades[4].volume = 10;
-        } else if (activeTrades[4].open) {
-            if ((t - activeTrades[4].entryTick >= holdPeriod) || (alphaBear == -1)) {
-                activeTrades[4].exitTick = t;
-                activeTrades[4].exitPrice = S_new;
-                double payoff = bearSpreadPayoff(S_new, activeTrades[4].strike1, activeTrades[4].strike2);
-                activeTrades[4].payoff = payoff * activeTrades[4].volume;
-                cumulativePnL[4] += activeTrades[4].payoff;
-                activeTrades[4].open = false;
-            }
+// Strategy PnL and option price sensitivities by adjoint AD, checked
+// against the simulation and against bump-and-revalue
+void runAad(const SimParams& p, SimMemory& mem, uint64_t seed) {
+    const AadParams& ap = p.aad;
+    SimResult sim = runSimulation(p, mem, seed);
+    size_t mark = mem.arena.mark();
+    SensitivityResult r;
+    {
+        SensitivityEngine engine(p, mem.arena, seed);
+        r = engine.run();
+    }
+    mem.arena.rewind(mark);
+
+    double total = 0, hard = 0, simTotal = 0;
+    cout << "PnL per strategy, smoothed replay / hard replay / simulation (smoothing " << ap.smoothing << "):" << endl;
+    for (int i = 1; i <= 5; i++) {
+        cout << "  Strategy " << i << " (" << kStrategyNames[i] << "): " << r.pnl[i] << " / " << r.hardPnL[i] << " / "
+             << sim.cumulativePnL[i] << endl;
+        total += r.pnl[i];
+        hard += r.hardPnL[i];
+        simTotal += sim.cumulativePnL[i];
+    }
+    cout << "Total PnL: " << total << " / " << hard << " / " << simTotal << endl;
+
+    cout << "PnL sensitivities to the model:" << endl;
+    for (int i = 1; i <= 5; i++) {
+        cout << "  Strategy " << i << ":";
+        for (int m = 0; m < MODEL_INPUTS; m++) cout << " d/d" << kModelInputNames[m] << " " << r.model[i][m];
+        cout << endl;
+    }
+    cout << "PnL sensitivities to each strategy's own parameters:" << endl;
+    for (int i = 1; i <= 5; i++) {
+        if (!p.strategy[i].enabled) continue;
+        cout << "  Strategy " << i << ":";
+        for (int s = 0; s < STRATEGY_INPUTS; s++) {
+            // Thresholds the strategy's signals do not read
+            if ((i == BULL || i == BEAR) && (s == IN_ENTRY || s == IN_EXIT)) continue;
+            cout << (s ? ", " : " ") << kStrategyInputNames[s] << " " << r.strategy[i][s];
         }
+        cout << endl;
+    }
+
+    cout << "Tape: " << r.tapeNodes << " nodes (" << r.tapeNodes / (p.totalTicks - 1) << " per tick)" << endl;
+    const double aadMs = r.tapedMs + r.reverseMs;
+    cout << "AAD: taped replay " << r.tapedMs << " ms + 5-lane reverse sweep " << r.reverseMs << " ms = "
+         << (r.forwardMs > 0 ? aadMs / r.forwardMs : 0.0) << "x a plain replay (" << r.forwardMs << " ms)" << endl;
+    if (ap.check) {
+        cout << "Bump and revalue: " << r.bumpRuns << " replays, " << r.bumpMs << " ms ("
+             << (aadMs > 0 ? r.bumpMs / aadMs : 0.0) << "x AAD); max difference " << r.bumpError
+             << " relative to max(|AAD|, 1)" << endl;
+    }
+
+    const LsmParams& lp = p.lsm;
+    double delta, gamma, vega;
+    blackScholesGreeks(p.model.S0, lp.strike, lp.maturity, p.model.sigma, lp.rate, lp.isCall, delta, gamma, vega);
+    cout << "European " << (lp.isCall ? "call" : "put") << ", strike " << lp.strike << ", maturity " << lp.maturity
+         << ": " << r.option << ", adjoints (Black-Scholes in brackets):" << endl;
+    for (int i = 0; i < OPTION_INPUTS; i++) {
+        cout << "  d/d" << kOptionInputNames[i] << ": " << r.optionAdjoint[i];
+        if (i == OPT_SPOT) cout << " [" << delta << "]";
+        if (i == OPT_SIGMA) cout << " [" << vega << "]";
+        cout << endl;
+    }
+}
 
-        // Strategy 5: Butterfly Spread (calls)
-        if (!activeTrades[5].open && alphaButterfly == +1) {
-            activeTrades[5].open = true;
-            activeTrades[5].strategyType = 5;
-            activeTrades[5].entryTick = t;
-            activeTrades[5].entryPrice = S_new;
-            // For a butterfly spread, use three strikes:
-            activeTrades[5].strike1 = S_new * (1 - delta);
-            activeTrades[5].strike2 = S_new; 
-            activeTrades[5].strike3 = S_new * (1 + delta);
-            activeTrades[5].volume = 10;
-        } else if (activeTrades[5].open) {
-            if ((t - activeTrades[5].entryTick >= holdPeriod) || (alphaButterfly == -1)) {
-                activeTrades[5].exitTick = t;
-                activeTrades[5].exitPrice = S_new;
-                double payoff = butterflySpreadPayoff(S_new, activeTrades[5].strike1, activeTrades[5].strike2, activeTrades[5].strike3);
-                activeTrades[5].payoff = payoff * activeTrades[5].volume;
-                cumulativePnL[5] += activeTrades[5].payoff;
-                activeTrades[5].open = false;
+// Runs the strategies on ticks received from the market-data feed until
+// the publisher's end packet, run.ticks ticks, or the idle timeout.
+void runFeed(const SimParams& p, SimMemory& mem) {
+    size_t mark = mem.arena.mark();
+    {
+        FeedHandler feed(p, mem);
+        cout << "Listening on " << p.feed.group << ":" << p.feed.port << " ("
+             << (p.feed.busyPoll ? "busy poll" : "blocking") << ", " << p.feed.batch << " datagrams per call)" << endl;
+        FeedResult r = feed.run();
+        reportSingle(r.sim);
+        if (p.costs) reportCosts(r.sim.cumulativePnL, r.sim.fees, r.sim.slippage, r.sim.impact);
+        if (p.risk.enabled) reportRisk(r.sim.risk);
+        cout << "Feed: " << r.ticks << " ticks in " << r.packets << " packets over " << r.receiveCalls
+             << " receive calls (" << (r.receiveCalls ? (double)r.packets / r.receiveCalls : 0.0) << " per call), "
+             << (r.ended ? "end of replay" : r.full ? "run.ticks reached" : "idle timeout") << endl;
+        cout << "  Sequence gaps: " << r.gaps << " (" << r.missing << " packets missing), "
+             << r.malformed << " malformed" << endl;
+        cout << "  Packet-to-signal latency: mean " << r.meanNs << " ns, p50 " << r.p50Ns << " ns, p99 "
+             << r.p99Ns << " ns, max " << r.maxNs << " ns" << endl;
+    }
+    mem.arena.rewind(mark);
+}
+
+// Single path through the order gateway: strategy threads publish intents,
+// the gateway fills them against the book. PnL matches single mode.
+void runGateway(const SimParams& p, SimMemory& mem, uint64_t seed) {
+    size_t mark = mem.arena.mark();
+    OrderGateway gateway(p, mem, seed);
+    GatewayStats g;
+    SimResult r = gateway.run(g);
+    reportSingle(r);
+    if (p.costs) reportCosts(r.cumulativePnL, r.fees, r.slippage, r.impact);
+    if (p.risk.enabled) reportRisk(r.risk);
+    cout << "Gateway: " << g.intents << " intents in " << g.batches << " batches ("
+         << (g.batches ? (double)g.intents / g.batches : 0.0) << " per batch), " << g.rejected << " rejected" << endl;
+    cout << "  Queue wait: mean " << g.meanQueueNs << " ns, max " << g.maxQueueNs << " ns; deepest ring "
+         << g.maxDepth << " of " << p.gateway.queueCapacity << ", " << g.producerStalls << " producer stalls" << endl;
+    cout << "  5 strategy threads + gateway: " << g.ms << " ms" << endl;
+    mem.arena.rewind(mark);
+}
+
+template <class Codec>
+SimResult runSessionWith(const SimParams& p, SimMemory& mem, uint64_t seed, SessionStats& s) {
+    OrderSession<Codec> session(p, mem, seed);
+    return session.run(s);
+}
+
+// Single path with every order sent over a TCP order-entry session to a
+// local matching engine. PnL matches single mode.
+void runSession(const SimParams& p, SimMemory& mem, uint64_t seed) {
+    size_t mark = mem.arena.mark();
+    SessionStats s;
+    SimResult r = p.session.encoding == ENCODING_FIX ? runSessionWith<FixCodec>(p, mem, seed, s)
+                                                     : runSessionWith<BinaryCodec>(p, mem, seed, s);
+    reportSingle(r);
+    if (p.costs) reportCosts(r.cumulativePnL, r.fees, r.slippage, r.impact);
+    if (p.risk.enabled) reportRisk(r.risk);
+    cout << "Session (" << s.encoding << ", 127.0.0.1:" << s.port << "): " << s.orders << " orders, "
+         << s.rejected << " rejected by the engine, " << s.bytesOut << " bytes out, " << s.bytesIn << " bytes in" << endl;
+    cout << "  Order round trip: mean " << s.meanRttNs << " ns, p50 " << s.p50RttNs << " ns, p99 "
+         << s.p99RttNs << " ns, max " << s.maxRttNs << " ns" << endl;
+    cout << "  Codec: new order " << s.orderBytes << " bytes, report " << s.reportBytes << " bytes; encode "
+         << s.encodeNs << " ns, decode " << s.decodeNs << " ns per message" << endl;
+    cout << "  Logon to logout: " << s.ms << " ms" << endl;
+    mem.arena.rewind(mark);
+}
+
+// Runs every strategy over every stress scenario and reports the scenario x
+// strategy PnL matrix (the worst scenarios when there are many), optionally
+// writing all of it to CSV.
+void runStress(const SimParams& p, SimMemory& mem, uint64_t seed) {
+    static const char* const kindNames[] = {"base", "gap", "vol_spike", "crash", "trend"};
+    size_t mark = mem.arena.mark();
+    StressEngine engine(p, mem, seed);
+    vector<double> pnl;
+    vector<RiskStats> risk;
+    double ms = engine.run(pnl, risk);
+    const vector<Scenario>& sc = engine.scenarios();
+
+    vector<size_t> order(sc.size());
+    vector<double> total(sc.size(), 0.0);
+    for (size_t i = 0; i < sc.size(); i++) {
+        order[i] = i;
+        for (int k = 1; k <= 5; k++) total[i] += pnl[i * 6 + k];
+    }
+    // Base first, then worst total PnL first
+    sort(order.begin() + 1, order.end(), [&total](size_t a, size_t b) { return total[a] < total[b]; });
+    const size_t shown = min(sc.size(), (size_t)21);
+    cout << "Scenario x strategy PnL (" << sc.size() << " scenarios"
+         << (shown < sc.size() ? ", worst 20 shown" : "") << "):" << endl;
+    cout << "  scenario             start";
+    for (int k = 1; k <= 5; k++) cout << "  S" << k;
+    cout << "  total" << endl;
+    for (size_t j = 0; j < shown; j++) {
+        size_t i = order[j];
+        ostringstream name;
+        name << kindNames[sc[i].kind];
+        if (sc[i].kind != SCEN_BASE) name << "(" << sc[i].size << ")";
+        cout << "  " << left << setw(20) << name.str() << right << " " << setw(5) << (sc[i].kind == SCEN_BASE ? 0 : sc[i].start);
+        for (int k = 1; k <= 5; k++) cout << "  " << pnl[i * 6 + k];
+        cout << "  " << total[i] << endl;
+    }
+    cout << sc.size() << " scenarios on " << p.stress.threads << " threads: " << ms << " ms" << endl;
+    if (p.risk.enabled) {
+        // Counts summed over scenarios, cost per check averaged over all checks
+        RiskStats all = risk[0];
+        double ns = all.nsPerCheck * all.checks;
+        for (size_t i = 1; i < risk.size(); i++) {
+            all.checks += risk[i].checks;
+            all.rejected += risk[i].rejected;
+            for (int c = 0; c < RISK_CHECKS; c++) all.failed[c] += risk[i].failed[c];
+            ns += risk[i].nsPerCheck * risk[i].checks;
+        }
+        all.nsPerCheck = all.checks ? ns / all.checks : 0.0;
+        cout << "Over all scenarios:" << endl;
+        reportRisk(all);
+    }
+
+    if (!p.stress.output.empty()) {
+        ofstream out(p.stress.output.c_str());
+        if (!out) throw runtime_error("cannot write " + p.stress.output);
+        out.precision(10);
+        out << "kind,size,start";
+        for (int k = 1; k <= 5; k++) out << "," << kStrategyKeys[k];
+        out << ",total\n";
+        for (size_t i = 0; i < sc.size(); i++) {
+            out << kindNames[sc[i].kind] << "," << sc[i].size << "," << sc[i].start;
+            for (int k = 1; k <= 5; k++) out << "," << pnl[i * 6 + k];
+            out << "," << total[i] << "\n";
+        }
+        cout << "Matrix written to " << p.stress.output << endl;
+    }
+    mem.arena.rewind(mark);
+}
+
+// Fills in memory sizes the config left at 0 from what the run mode needs,
+// and rejects pools set too small for it.
+void autoSizeMemory(SimParams& p) {
+    MemoryConfig& m = p.memory;
+    size_t arena = (size_t)p.totalTicks * sizeof(double) + (1 << 20);
+    size_t trades = 64;
+    if (p.mode == RUN_MULTI) {
+        int maxWindow = max(p.longWindow, max(p.shortWindow, p.volWindow));
+        arena += portfolioArenaBytes(p.portfolio.assets, p.portfolio.block, maxWindow);
+        trades = max(trades, (size_t)p.portfolio.assets * 5);
+    }
+    if (usesStreamingBank(p)) arena += streamingBankArenaBytes(p, p.mode == RUN_MULTI ? p.portfolio.assets : 1);
+    if (p.batch > 1) arena += (size_t)p.batch * (3 * sizeof(double) + sizeof(SignalMask)) + 4 * 64;
+    if (p.chain.enabled) arena += OptionChain::arenaBytes(p.chain) + sizeof(OptionChain);
+    if (p.latency.enabled) arena += LatencyModel::arenaBytes() + sizeof(LatencyModel);
+    if (p.mode == RUN_EVENT || p.mode == RUN_LATENCY) arena += EventSimulation::arenaBytes(m);
+    if (p.risk.enabled) arena += sizeof(RiskEngine) + 64;
+    if (p.mode == RUN_FEED) arena += FeedHandler::arenaBytes(p) + streamingBankArenaBytes(p, 1);
+    if (p.mode == RUN_GATEWAY) arena += OrderGateway::arenaBytes(p);
+    if (p.mode == RUN_SESSION) arena += OrderSession<BinaryCodec>::arenaBytes(p);
+    if (p.mode == RUN_STRESS) arena += StressEngine::arenaBytes(p);
+    if (p.mode == RUN_LSM) arena += LsmEngine::arenaBytes(p.lsm);
+    if (p.mode == RUN_AAD) arena += SensitivityEngine::arenaBytes(p);
+    if (p.expiry.enabled) arena += OptionLifecycle::arenaBytes(p.expiry) + sizeof(OptionLifecycle) + 64;
+    if (p.american.enabled) arena += PositionMarker::arenaBytes(p.american) + sizeof(PositionMarker);
+    // A book holds at most one trade, and event mode at most one order in
+    // flight, per strategy; an explicit pool smaller than that would run dry
+    const size_t books = p.mode == RUN_MULTI ? (size_t)p.portfolio.assets : 1;
+    if (m.tradePoolSize != 0 && m.tradePoolSize < books * 5)
+        throw runtime_error("memory.trade_pool must be at least " + to_string(books * 5) + " in this mode");
+    if ((p.mode == RUN_EVENT || p.mode == RUN_LATENCY) && m.orderPoolSize < 5)
+        throw runtime_error("memory.order_pool must be at least 5 in event and latency modes");
+    if (m.tradePoolSize == 0) m.tradePoolSize = trades;
+    if (m.arenaBytes == 0) m.arenaBytes = arena + m.tradePoolSize * sizeof(Trade);
+}
+
+void printUsage(const char* prog) {
+    cerr << "usage: " << prog << " [config.toml] [--set section.key=value ...]" << endl;
+}
+
+// -------------------------
+// Main Simulation
+// -------------------------
+int main(int argc, char** argv) {
+    // Load the run configuration; with no file every parameter takes its
+    // built-in default.
+    SimParams params;
+    vector<SimParams> sweepSets;
+    try {
+        ConfigFile cfg;
+        vector<string> overrides;
+        for (int i = 1; i < argc; i++) {
+            if (strcmp(argv[i], "--set") == 0 && i + 1 < argc) {
+                overrides.push_back(argv[++i]);
+            } else if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0) {
+                printUsage(argv[0]);
+                return 0;
+            } else if (argv[i][0] == '-') {
+                printUsage(argv[0]);
+                return 1;
+            } else {
+                cfg.load(argv[i]);
             }
         }
-    } // end simulation loop
+        // Overrides win over the file regardless of argument order
+        for (size_t i = 0; i < overrides.size(); i++) cfg.applyOverride(overrides[i]);
+        params = freezeSimParams(cfg);
+        autoSizeMemory(params);
 
-    // ----- Final Reporting -----
-    double totalPnL = 0;
-    cout << "Cumulative PnL per Strategy:" << endl;
-    for (int i = 1; i <= 5; i++) {
-        cout << "  Strategy " << i << ": " << cumulativePnL[i] << endl;
-        totalPnL += cumulativePnL[i];
+        // One frozen parameter set per swept value
+        if (params.mode == RUN_SWEEP) {
+            if (params.sweep.param.empty()) sweepSets.push_back(params);
+            for (size_t i = 0; i < params.sweep.values.size(); i++) {
+                ConfigFile c = cfg;
+                ostringstream value;
+                value.precision(15);
+                value << params.sweep.values[i];
+                c.set(params.sweep.param, value.str());
+                sweepSets.push_back(freezeSimParams(c));
+                autoSizeMemory(sweepSets.back());
+            }
+        }
+    } catch (const exception& e) {
+        cerr << "config error: " << e.what() << endl;
+        return 1;
     }
-    cout << "Total PnL: " << totalPnL << endl;
 
+    uint64_t seed = resolveSeed(params.seed);
+    try {
+        SimMemory mem(params.memory);
+        switch (params.mode) {
+        case RUN_SINGLE:
+            runSingle(params, mem, seed);
+            break;
+        case RUN_PATHS:
+            runPaths(params, mem, seed);
+            break;
+        case RUN_MULTI:
+            runMulti(params, mem, seed);
+            break;
+        case RUN_EVENT:
+            runEvent(params, mem, seed);
+            break;
+        case RUN_LATENCY:
+            runLatencySweep(params, mem, seed);
+            break;
+        case RUN_SWEEP:
+            runSweep(sweepSets, seed);
+            break;
+        case RUN_LSM:
+            runLsm(params, mem, seed);
+            break;
+        case RUN_STRESS:
+            runStress(params, mem, seed);
+            break;
+        case RUN_GATEWAY:
+            runGateway(params, mem, seed);
+            break;
+        case RUN_FEED:
+            runFeed(params, mem);
+            break;
+        case RUN_SESSION:
+            runSession(params, mem, seed);
+            break;
+        case RUN_AAD:
+            runAad(params, mem, seed);
+            break;
+        }
+    } catch (const exception& e) {
+        cerr << "error: " << e.what() << endl;
+        return 1;
+    }
     return 0;
 }
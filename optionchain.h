@@ -0,0 +1,227 @@
+#ifndef OPTIONCHAIN_H
+#define OPTIONCHAIN_H
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include "arena.h"
+#include "config.h"
+#include "fastrng.h"
+
+// -------------------------
+// Fast Black-Scholes building blocks
+// All times are in ticks and vols are per tick, matching the GBM model.
+// -------------------------
+
+// Standard normal tail from the density: Abramowitz & Stegun 26.2.17,
+// 1 - N(|x|) = pdf(x) * normTailPoly(1 / (1 + kNormTailP |x|)) with
+// |error| < 7.5e-8. Splitting out the density and the reciprocal lets
+// callers share one exp and one division between N(d1) and N(d2).
+const double kNormTailP = 0.2316419;
+
+inline double normTailPoly(double t) {
+    return t * (0.319381530 + t * (-0.356563782 + t * (1.781477937 + t * (-1.821255978 + t * 1.330274429))));
+}
+
+// 2^(j/64) for j = 0..63, filled once on first use
+struct Exp2Fractions {
+    double v[64];
+    Exp2Fractions() {
+        for (int j = 0; j < 64; j++) v[j] = std::exp2(j / 64.0);
+    }
+};
+
+inline const double* exp2Fractions() {
+    static const Exp2Fractions table;
+    return table.v;
+}
+
+// exp(x) for x <= 0 without a libm call: x = (64k + j) ln2/64 + r with
+// |r| <= ln2/128, e^r from a short Taylor series, 2^(j/64) from a table and
+// 2^k assembled in the exponent bits. Relative error ~1e-13; everything
+// is straight-line so it pipelines (and vectorizes where the compiler
+// chooses to).
+inline double expNonPositive(double x) {
+    const double shifter = 6755399441055744.0;   // 1.5 * 2^52: rounds to integer
+    x = x < -700.0 ? -700.0 : x;
+    double nf = x * (64 * 1.4426950408889634) + shifter;
+    int64_t nbits;
+    std::memcpy(&nbits, &nf, sizeof(nbits));
+    nf -= shifter;
+    double r = x - nf * (0.6931471805599453 / 64);
+    double p = 1.0 + r * (1.0 + r * (0.5 + r * (1.0 / 6 + r * (1.0 / 24))));
+    int64_t bits = (int64_t)((uint64_t)((nbits >> 6) + 1023) << 52);
+    double scale;
+    std::memcpy(&scale, &bits, sizeof(scale));
+    return p * scale * exp2Fractions()[nbits & 63];
+}
+
+// -------------------------
+// Synthetic option chain
+// A fixed grid of strikes x expiries. Quotes live in per-expiry
+// contiguous arrays (expiry e occupies [e*nStrikes, (e+1)*nStrikes)) and
+// are overwritten in place on every underlying tick. Expiries are a ring:
+// when the front expiry passes, its slot is relisted as the new back month.
+// Time to expiry is a whole number of ticks no longer than maxTau(), so
+// the term-structure scaling comes from tables instead of a pow per expiry.
+// -------------------------
+struct OptionChain {
+    int nStrikes;
+    int nExpiries;
+    double strikeSpacing;   // absolute distance between listed strikes
+    double firstStrike;     // lowest listed strike
+    int frontSlot;          // ring slot of the nearest expiry
+    const ChainParams* cp;
+    XorShift64 rng;
+
+    double* strikes;        // nStrikes, shared by all expiries
+    double* logStrikes;     // log of each strike
+    int* expiryTick;        // nExpiries, tick at which each slot expires
+    double* sqrtTau;        // maxTau + 1, sqrt of ticks to expiry
+    double* termVol;        // maxTau + 1, (tau / firstExpiry)^termSlope * sqrt(tau)
+    double* callBid;        // nExpiries * nStrikes
+    double* callAsk;
+    double* putBid;
+    double* putAsk;
+    double* scratchD1;      // nStrikes of per-expiry working space
+    double* scratchVol;
+    double* scratchPdf;
+
+    OptionChain(const ChainParams& params, double spot, uint64_t seed, Arena& arena)
+        : nStrikes(params.strikes), nExpiries(params.expiries), frontSlot(0), cp(&params), rng(seed) {
+        size_t series = (size_t)nStrikes * nExpiries;
+        strikes    = arena.allocArray<double>(nStrikes);
+        logStrikes = arena.allocArray<double>(nStrikes);
+        expiryTick = arena.allocArray<int>(nExpiries);
+        sqrtTau    = arena.allocArray<double>(maxTau(params) + 1);
+        termVol    = arena.allocArray<double>(maxTau(params) + 1);
+        callBid    = arena.allocArray<double>(series);
+        callAsk    = arena.allocArray<double>(series);
+        putBid     = arena.allocArray<double>(series);
+        putAsk     = arena.allocArray<double>(series);
+        scratchD1  = arena.allocArray<double>(nStrikes);
+        scratchVol = arena.allocArray<double>(nStrikes);
+        scratchPdf = arena.allocArray<double>(nStrikes);
+        listStrikes(spot);
+        for (int e = 0; e < nExpiries; e++) expiryTick[e] = params.firstExpiry + e * params.expirySpacing;
+        sqrtTau[0] = termVol[0] = 0.0;   // never read: an expiry rolls at tau = 0
+        for (int tau = 1; tau <= maxTau(params); tau++) {
+            sqrtTau[tau] = std::sqrt((double)tau);
+            termVol[tau] = std::pow(tau / (double)params.firstExpiry, params.termSlope) * sqrtTau[tau];
+        }
+    }
+
+    // Longest time to expiry: the initial back month, or a full ring of
+    // expiries after a roll
+    static int maxTau(const ChainParams& params) {
+        int initial = params.firstExpiry + (params.expiries - 1) * params.expirySpacing;
+        int rolled = params.expiries * params.expirySpacing;
+        return initial > rolled ? initial : rolled;
+    }
+
+    static size_t arenaBytes(const ChainParams& params) {
+        size_t series = (size_t)params.strikes * params.expiries;
+        return (5 * params.strikes + 4 * series + 2 * (maxTau(params) + 1)) * sizeof(double)
+             + params.expiries * sizeof(int) + 10 * 64;
+    }
+
+    // Lists nStrikes strikes centred on the spot, strike_spacing of the
+    // spot apart. The config keeps the lowest one positive.
+    void listStrikes(double spot) {
+        strikeSpacing = spot * cp->strikeSpacing;
+        firstStrike = spot - (nStrikes / 2) * strikeSpacing;
+        for (int k = 0; k < nStrikes; k++) {
+            strikes[k] = firstStrike + k * strikeSpacing;
+            logStrikes[k] = std::log(strikes[k]);
+        }
+    }
+
+    int slot(int i) const { return (frontSlot + i) % nExpiries; }   // i-th nearest expiry
+
+    // Listed strike nearest to K
+    double nearestStrike(double K) const {
+        int k = (int)std::floor((K - firstStrike) / strikeSpacing + 0.5);
+        k = k < 0 ? 0 : (k >= nStrikes ? nStrikes - 1 : k);
+        return strikes[k];
+    }
+
+    // Reprices every series for underlying price spot at tick t. Implied
+    // vol per tick comes from the surface: skew and smile in standardised
+    // moneyness m = log(K/F) / sqrt(T), scaled by the term structure
+    // factor (T / firstExpiry)^termSlope and floored at minVol.
+    void update(double spot, int t) {
+        // Roll expired months to the back of the ring
+        while (expiryTick[frontSlot] <= t) {
+            int back = slot(nExpiries - 1);
+            expiryTick[frontSlot] = expiryTick[back] + cp->expirySpacing;
+            frontSlot = (frontSlot + 1) % nExpiries;
+        }
+        // Relist strikes when the spot leaves the middle half of the grid
+        double lo = strikes[nStrikes / 4], hi = strikes[nStrikes - 1 - nStrikes / 4];
+        if (spot < lo || spot > hi) listStrikes(spot);
+
+        // Surface parameters go into locals: the quote stores below could
+        // alias them, which would force a reload every iteration.
+        const double skew = cp->skew, smile = cp->smile, minVol = cp->minVol;
+        const double spread = cp->spread, halfTick = 0.5 * cp->tickSize;
+        const double logF = std::log(spot);
+        const double level = cp->atmVol * (1.0 + cp->volNoise * rng.symmetric());
+        const double* K = strikes;
+        const double* logK = logStrikes;
+        for (int e = 0; e < nExpiries; e++) {
+            int tau = expiryTick[e] - t;
+            double sqrtT = sqrtTau[tau];
+            double invSqrtT = 1.0 / sqrtT;
+            double base = level * termVol[tau];
+            double floorVol = minVol * sqrtT;
+            double* __restrict cb = callBid + (size_t)e * nStrikes;
+            double* __restrict ca = callAsk + (size_t)e * nStrikes;
+            double* __restrict pb = putBid + (size_t)e * nStrikes;
+            double* __restrict pa = putAsk + (size_t)e * nStrikes;
+            // Straight-line passes over the expiry's strikes so each one can
+            // run as a SIMD loop: d1 and the exponent, the shared density,
+            // the call price, then put-call parity and the quotes.
+            double* d1s = scratchD1;
+            double* vols = scratchVol;
+            double* pdf = scratchPdf;
+            for (int k = 0; k < nStrikes; k++) {
+                double logFK = logF - logK[k];
+                double m = -logFK * invSqrtT;
+                double vol = base * (1.0 + skew * m + smile * m * m);
+                vol = vol > floorVol ? vol : floorVol;
+                double d1 = logFK / vol + 0.5 * vol;
+                d1s[k] = d1;
+                vols[k] = vol;
+                pdf[k] = -0.5 * d1 * d1;
+            }
+            for (int k = 0; k < nStrikes; k++) pdf[k] = 0.3989422804014327 * expNonPositive(pdf[k]);
+            // K n(d2) = F n(d1), so both tails scale the same density, and
+            // one division gives both reciprocals 1 / (1 + p|d|).
+            double* calls = d1s;   // d1 is dead once the call is priced
+            for (int k = 0; k < nStrikes; k++) {
+                double d1 = d1s[k];
+                double d2 = d1 - vols[k];
+                double a1 = 1.0 + kNormTailP * std::fabs(d1);
+                double a2 = 1.0 + kNormTailP * std::fabs(d2);
+                double r = 1.0 / (a1 * a2);
+                double density = spot * pdf[k];
+                double tail1 = density * normTailPoly(r * a2);   // F (1 - N(|d1|))
+                double tail2 = density * normTailPoly(r * a1);   // K (1 - N(|d2|))
+                calls[k] = (d1 >= 0.0 ? spot - tail1 : tail1) - (d2 >= 0.0 ? K[k] - tail2 : tail2);
+            }
+            for (int k = 0; k < nStrikes; k++) {
+                double call = calls[k];
+                double put = call - spot + K[k];   // put-call parity, zero rates
+                put = put > 0.0 ? put : 0.0;
+                double halfCall = halfTick + spread * call;
+                double halfPut  = halfTick + spread * put;
+                cb[k] = call - halfCall > 0.0 ? call - halfCall : 0.0;
+                ca[k] = call + halfCall;
+                pb[k] = put - halfPut > 0.0 ? put - halfPut : 0.0;
+                pa[k] = put + halfPut;
+            }
+        }
+    }
+};
+
+#endif // OPTIONCHAIN_H
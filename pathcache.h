@@ -0,0 +1,155 @@
+#ifndef PATHCACHE_H
+#define PATHCACHE_H
+
+#include <cerrno>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "config.h"
+#include "simulation.h"
+
+// Everything a cached path set depends on. Compared field by field on
+// open, so a hash collision can never return the wrong paths.
+struct PathKey {
+    uint32_t model;      // 0 = GBM
+    uint32_t ticks;
+    double S0, mu, sigma, dt;
+    uint64_t firstSeed;  // path i uses seed firstSeed + i
+    uint64_t paths;
+};
+
+// Padded to 64 bytes so the prices after it start cache-line aligned
+struct alignas(64) PathFileHeader {
+    char magic[8];       // "HFTPATH1"
+    PathKey key;
+};
+static_assert(sizeof(PathFileHeader) == 64, "path file header must stay one cache line");
+
+// -------------------------
+// Memory-mapped path cache
+// A path set (consecutive seeds, same model and parameters) lives in one
+// file under the cache directory, named by a hash of its key: a 64-byte
+// header followed by paths x ticks doubles. The first run generates the
+// file and renames it into place; later runs map it read-only and read
+// prices straight from the page cache. Forked sweep workers inherit the
+// mapping.
+// -------------------------
+class PathCache {
+public:
+    // Maps paths seeds firstSeed.. of p's model, generating the file first
+    // if no valid one exists.
+    PathCache(const SimParams& p, uint64_t firstSeed, uint64_t paths, const std::string& dir)
+        : base_(nullptr), bytes_(0), generated_(false) {
+        std::memset(&key_, 0, sizeof(key_));
+        key_.model = 0;
+        key_.ticks = (uint32_t)p.totalTicks;
+        key_.S0 = p.model.S0;
+        key_.mu = p.model.mu;
+        key_.sigma = p.model.sigma;
+        key_.dt = p.model.dt;
+        key_.firstSeed = firstSeed;
+        key_.paths = paths;
+        bytes_ = sizeof(PathFileHeader) + key_.paths * key_.ticks * sizeof(double);
+
+        mkdir(dir.c_str(), 0755);   // EEXIST is fine
+        path_ = dir + "/paths-" + hexHash() + ".bin";
+        if (!mapExisting()) {
+            generate(p);
+            generated_ = true;
+            if (!mapExisting()) throw std::runtime_error("cannot map generated path cache " + path_);
+        }
+    }
+
+    ~PathCache() {
+        if (base_) munmap(base_, bytes_);
+    }
+
+    PathCache(const PathCache&) = delete;
+    PathCache& operator=(const PathCache&) = delete;
+
+    // Prices of path i (seed firstSeed + i), totalTicks long
+    const double* path(uint64_t i) const {
+        return reinterpret_cast<const double*>(static_cast<const char*>(base_) + sizeof(PathFileHeader)) + i * key_.ticks;
+    }
+
+    bool generated() const { return generated_; }
+    const std::string& file() const { return path_; }
+
+private:
+    // FNV-1a over the key bytes
+    std::string hexHash() const {
+        uint64_t h = 1469598103934665603ull;
+        const unsigned char* b = reinterpret_cast<const unsigned char*>(&key_);
+        for (size_t i = 0; i < sizeof(key_); i++) {
+            h ^= b[i];
+            h *= 1099511628211ull;
+        }
+        char buf[17];
+        std::snprintf(buf, sizeof(buf), "%016llx", (unsigned long long)h);
+        return buf;
+    }
+
+    bool mapExisting() {
+        int fd = open(path_.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st;
+        bool ok = fstat(fd, &st) == 0 && (size_t)st.st_size == bytes_;
+        void* m = ok ? mmap(nullptr, bytes_, PROT_READ, MAP_SHARED, fd, 0) : MAP_FAILED;
+        close(fd);
+        if (m == MAP_FAILED) return false;
+        const PathFileHeader* h = static_cast<const PathFileHeader*>(m);
+        if (std::memcmp(h->magic, "HFTPATH1", 8) != 0 || std::memcmp(&h->key, &key_, sizeof(key_)) != 0) {
+            munmap(m, bytes_);
+            return false;
+        }
+        madvise(m, bytes_, MADV_SEQUENTIAL);
+        base_ = m;
+        return true;
+    }
+
+    // Writes the file under a temporary name and renames it into place,
+    // so concurrent or interrupted runs never see a partial cache.
+    void generate(const SimParams& p) {
+        std::string tmp = path_ + ".tmp." + std::to_string((long long)getpid());
+        int fd = open(tmp.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) throw std::runtime_error("cannot create path cache " + tmp + ": " + std::strerror(errno));
+        if (ftruncate(fd, (off_t)bytes_) != 0) {
+            close(fd);
+            unlink(tmp.c_str());
+            throw std::runtime_error("cannot size path cache " + tmp + ": " + std::strerror(errno));
+        }
+        void* m = mmap(nullptr, bytes_, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (m == MAP_FAILED) {
+            unlink(tmp.c_str());
+            throw std::runtime_error("cannot map path cache " + tmp);
+        }
+        PathFileHeader* h = static_cast<PathFileHeader*>(m);
+        std::memset(h, 0, sizeof(*h));
+        std::memcpy(h->magic, "HFTPATH1", 8);
+        h->key = key_;
+        double* prices = reinterpret_cast<double*>(static_cast<char*>(m) + sizeof(PathFileHeader));
+        for (uint64_t i = 0; i < key_.paths; i++)
+            generatePath(p.model, key_.firstSeed + i, prices + i * key_.ticks, (int)key_.ticks);
+        msync(m, bytes_, MS_SYNC);
+        munmap(m, bytes_);
+        if (rename(tmp.c_str(), path_.c_str()) != 0) {
+            unlink(tmp.c_str());
+            throw std::runtime_error("cannot install path cache " + path_);
+        }
+    }
+
+    PathKey key_;
+    std::string path_;
+    void* base_;
+    size_t bytes_;
+    bool generated_;
+};
+
+#endif // PATHCACHE_H
@@ -0,0 +1,295 @@
+#ifndef PORTFOLIO_H
+#define PORTFOLIO_H
+
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "arena.h"
+#include "config.h"
+#include "simulation.h"
+#include "strategies.h"
+
+// -------------------------
+// Correlation matrix and Cholesky factor
+// Matrices are dense row-major n x n, with the row stride padded to a
+// multiple of the block size so blocked kernels never need edge checks
+// on the column dimension.
+// -------------------------
+inline int paddedDim(int n, int block) {
+    return (n + block - 1) / block * block;
+}
+
+// Uniform pairwise correlation rho, or the CSV file if one is given.
+inline void buildCorrelation(const PortfolioParams& pp, double* C, int ld) {
+    int n = pp.assets;
+    for (int i = 0; i < n; i++)
+        for (int j = 0; j < ld; j++)
+            C[i * ld + j] = j >= n ? 0.0 : (i == j ? 1.0 : pp.correlation);
+    if (pp.correlationFile.empty()) return;
+
+    std::ifstream in(pp.correlationFile.c_str());
+    if (!in) throw std::runtime_error("cannot open correlation file: " + pp.correlationFile);
+    std::string line;
+    for (int i = 0; i < n; i++) {
+        if (!std::getline(in, line))
+            throw std::runtime_error("correlation file has fewer than " + std::to_string(n) + " rows");
+        std::stringstream ss(line);
+        std::string cell;
+        for (int j = 0; j < n; j++) {
+            if (!std::getline(ss, cell, ','))
+                throw std::runtime_error("correlation file row " + std::to_string(i + 1) + " is too short");
+            C[i * ld + j] = std::strtod(cell.c_str(), nullptr);
+        }
+    }
+}
+
+// In-place Cholesky: on return the lower triangle of A holds L with
+// A = L L^T and the strict upper triangle is zeroed.
+inline void choleskyFactor(double* A, int n, int ld) {
+    for (int j = 0; j < n; j++) {
+        double d = A[j * ld + j];
+        for (int k = 0; k < j; k++) d -= A[j * ld + k] * A[j * ld + k];
+        if (d <= 0.0) throw std::runtime_error("correlation matrix is not positive definite");
+        d = std::sqrt(d);
+        A[j * ld + j] = d;
+        for (int i = j + 1; i < n; i++) {
+            double s = A[i * ld + j];
+            for (int k = 0; k < j; k++) s -= A[i * ld + k] * A[j * ld + k];
+            A[i * ld + j] = s / d;
+        }
+        for (int k = j + 1; k < ld; k++) A[j * ld + k] = 0.0;
+    }
+}
+
+// y = L z for lower-triangular L, in block x block tiles. Tiles above
+// the diagonal are skipped; each tile's inner loop runs over contiguous
+// columns so it vectorizes.
+inline void lowerMatVecBlocked(const double* L, int ld, int block, const double* z, double* y, int n) {
+    for (int i = 0; i < ld; i++) y[i] = 0.0;
+    for (int ib = 0; ib < n; ib += block) {
+        int iEnd = ib + block < n ? ib + block : n;
+        for (int jb = 0; jb <= ib; jb += block) {
+            for (int i = ib; i < iEnd; i++) {
+                const double* row = L + (size_t)i * ld + jb;
+                double s = 0.0;
+                for (int j = 0; j < block; j++) s += row[j] * z[jb + j];
+                y[i] += s;
+            }
+        }
+    }
+}
+
+// -------------------------
+// Portfolio state (structure of arrays)
+// One slot per asset in every array; price history and log returns are
+// rings of rows, so a tick across all assets is a sweep over contiguous
+// rows.
+// -------------------------
+struct PortfolioState {
+    int n;              // number of assets
+    int ld;             // padded row length
+    int histRows;       // rows kept in the price/return rings
+    double* chol;       // ld x ld Cholesky factor
+    double* z;          // iid shocks for this tick
+    double* eps;        // correlated shocks for this tick
+    double* price;      // current prices
+    double* priceHist;  // histRows x ld price ring
+    double* retHist;    // histRows x ld log-return ring
+    double* shortMA;
+    double* longMA;
+    double* vol;
+    SignalMask* signals;   // packed alpha signals for this tick
+    StrategyBook* books;   // per-asset strategy instances
+
+    PortfolioState(const SimParams& p, Arena& arena) {
+        const PortfolioParams& pp = p.portfolio;
+        n = pp.assets;
+        ld = paddedDim(n, pp.block);
+        histRows = std::max(p.longWindow, std::max(p.shortWindow, p.volWindow)) + 1;
+        chol      = arena.allocArray<double>((size_t)ld * ld);
+        z         = arena.allocArray<double>(ld);
+        eps       = arena.allocArray<double>(ld);
+        price     = arena.allocArray<double>(ld);
+        priceHist = arena.allocArray<double>((size_t)histRows * ld);
+        retHist   = arena.allocArray<double>((size_t)histRows * ld);
+        shortMA   = arena.allocArray<double>(ld);
+        longMA    = arena.allocArray<double>(ld);
+        vol       = arena.allocArray<double>(ld);
+        signals   = arena.allocArray<SignalMask>(ld);
+        books     = arena.allocArray<StrategyBook>(n);
+        for (int i = 0; i < n; i++) new (&books[i]) StrategyBook();
+        for (int i = 0; i < ld; i++) {
+            z[i] = 0.0;
+            price[i] = p.model.S0;
+        }
+        buildCorrelation(pp, chol, ld);
+        for (int i = n; i < ld; i++)
+            for (int j = 0; j < ld; j++) chol[(size_t)i * ld + j] = 0.0;
+        choleskyFactor(chol, n, ld);
+    }
+
+    double* histRow(double* ring, int t) const { return ring + (size_t)(t % histRows) * ld; }
+};
+
+// Bytes of arena a portfolio of this shape needs (used to size SimMemory)
+inline size_t portfolioArenaBytes(int assets, int block, int maxWindow) {
+    size_t ld = (size_t)paddedDim(assets, block);
+    size_t rows = (size_t)maxWindow + 1;
+    return (ld * ld + 2 * rows * ld + 8 * ld) * sizeof(double) + ld * sizeof(SignalMask)
+         + assets * sizeof(StrategyBook) + 16 * 64;
+}
+
+// Mean over the last `window` rows of a ring for every asset, following
+// computeMA: before the window fills, the current value is returned.
+inline void ringMean(const PortfolioState& s, double* ring, int t, int window, double* out) {
+    if (t < window - 1) {
+        const double* cur = s.histRow(ring, t);
+        for (int i = 0; i < s.ld; i++) out[i] = cur[i];
+        return;
+    }
+    for (int i = 0; i < s.ld; i++) out[i] = 0.0;
+    for (int k = t - window + 1; k <= t; k++) {
+        const double* row = s.histRow(ring, k);
+        for (int i = 0; i < s.ld; i++) out[i] += row[i];
+    }
+    for (int i = 0; i < s.ld; i++) out[i] /= window;
+}
+
+// Population standard deviation of the last `window` log returns per
+// asset, following computeVolatility (0 until the window fills).
+inline void ringVolatility(const PortfolioState& s, int t, int window, double* out) {
+    if (t < window) {
+        for (int i = 0; i < s.ld; i++) out[i] = 0.0;
+        return;
+    }
+    double* mean = s.eps;   // eps is free once prices have been updated
+    for (int i = 0; i < s.ld; i++) mean[i] = 0.0;
+    for (int k = t - window + 1; k <= t; k++) {
+        const double* row = s.histRow(s.retHist, k);
+        for (int i = 0; i < s.ld; i++) mean[i] += row[i];
+    }
+    for (int i = 0; i < s.ld; i++) {
+        mean[i] /= window;
+        out[i] = 0.0;
+    }
+    for (int k = t - window + 1; k <= t; k++) {
+        const double* row = s.histRow(s.retHist, k);
+        for (int i = 0; i < s.ld; i++) out[i] += (row[i] - mean[i]) * (row[i] - mean[i]);
+    }
+    for (int i = 0; i < s.ld; i++) out[i] = std::sqrt(out[i] / window);
+}
+
+struct PortfolioResult {
+    double cumulativePnL[6];   // summed over assets
+    int tradeCount[6];
+    double fees[6];            // costs paid, summed over assets
+    double slippage[6];
+    double impact[6];
+    double bestAssetPnL;
+    double worstAssetPnL;
+    double nsPerTick;
+    ExpiryStats expiry;
+};
+
+// -------------------------
+// Multi-asset simulation
+// Every asset follows GBM with the model parameters, driven by shocks
+// correlated through the Cholesky factor, and runs its own copy of the
+// five strategies.
+// -------------------------
+inline PortfolioResult runPortfolio(const SimParams& p, SimMemory& mem, uint64_t seed) {
+    std::size_t arenaMark = mem.arena.mark();
+    PortfolioState s(p, mem.arena);
+    const int n = s.n;
+    const int block = p.portfolio.block;
+    const double drift = (p.model.mu - 0.5 * p.model.sigma * p.model.sigma) * p.model.dt;
+    const double diffusion = p.model.sigma * std::sqrt(p.model.dt);
+
+    std::default_random_engine generator((unsigned)seed);
+    std::normal_distribution<double> distribution(0.0, 1.0);
+
+    double* row0 = s.histRow(s.priceHist, 0);
+    double* ret0 = s.histRow(s.retHist, 0);
+    for (int i = 0; i < s.ld; i++) {
+        row0[i] = s.price[i];
+        ret0[i] = 0.0;
+    }
+    IndicatorBank* bank = makeStreamingBank(p, mem.arena, n, s.price);
+    OptionLifecycle* lc = makeLifecycle(p, mem.arena);
+    for (int i = 0; i < n; i++) {
+        s.books[i].lifecycle = lc;
+        s.books[i].underlying = i;
+    }
+
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    for (int t = 1; t < p.totalTicks; t++) {
+        // ----- Correlated GBM step for every asset -----
+        for (int i = 0; i < n; i++) s.z[i] = distribution(generator);
+        lowerMatVecBlocked(s.chol, s.ld, block, s.z, s.eps, n);
+        double* prow = s.histRow(s.priceHist, t);
+        double* rrow = s.histRow(s.retHist, t);
+        for (int i = 0; i < s.ld; i++) {
+            double r = drift + diffusion * s.eps[i];
+            s.price[i] *= std::exp(r);
+            prow[i] = s.price[i];
+            rrow[i] = r;
+        }
+
+        // ----- Expiries settle at the new prices -----
+        if (lc) settleExpiries(p, s.books, n, s.price, t, mem);
+
+        // ----- Indicators for all assets -----
+        const double* shortMA = s.shortMA;
+        const double* longMA = s.longMA;
+        const double* vol = s.vol;
+        if (bank) bank->update(s.price);
+        if (p.trend != TREND_SMA) {
+            shortMA = trendLine(p, *bank);
+            longMA = shortMA + n;
+        } else {
+            ringMean(s, s.priceHist, t, p.shortWindow, s.shortMA);
+            ringMean(s, s.priceHist, t, p.longWindow, s.longMA);
+        }
+        if (p.volSource != VOL_WINDOW) vol = streamedVol(p, *bank);
+        else ringVolatility(s, t, p.volWindow, s.vol);
+
+        // ----- Signals for all assets, then execution asset by asset -----
+        signalKernel(p, shortMA, longMA, vol, n, s.signals);
+        for (int i = 0; i < n; i++) executeStrategies(p, s.books[i], mem, t, s.price[i], s.signals[i]);
+    }
+    double elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    PortfolioResult r;
+    r.expiry = expiryStats(lc, s.books, n, s.price, p.totalTicks - 1);
+    for (int k = 0; k < 6; k++) {
+        r.cumulativePnL[k] = 0;
+        r.tradeCount[k] = 0;
+        r.fees[k] = r.slippage[k] = r.impact[k] = 0;
+    }
+    r.bestAssetPnL = -HUGE_VAL;
+    r.worstAssetPnL = HUGE_VAL;
+    for (int i = 0; i < n; i++) {
+        double assetPnL = 0;
+        for (int k = 1; k <= 5; k++) {
+            r.cumulativePnL[k] += s.books[i].cumulativePnL[k];
+            r.tradeCount[k] += s.books[i].tradeCount[k];
+            r.fees[k] += s.books[i].fees[k];
+            r.slippage[k] += s.books[i].slippage[k];
+            r.impact[k] += s.books[i].impact[k];
+            assetPnL += s.books[i].cumulativePnL[k];
+            if (s.books[i].active[k]) mem.trades.release(s.books[i].active[k]);
+        }
+        r.bestAssetPnL = std::max(r.bestAssetPnL, assetPnL);
+        r.worstAssetPnL = std::min(r.worstAssetPnL, assetPnL);
+    }
+    r.nsPerTick = elapsed / (p.totalTicks - 1);
+    mem.arena.rewind(arenaMark);
+    return r;
+}
+
+#endif // PORTFOLIO_H
@@ -0,0 +1,143 @@
+#ifndef RISK_H
+#define RISK_H
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include "config.h"
+
+enum RiskCheck { RISK_POSITION = 0, RISK_NOTIONAL, RISK_OPEN_ORDERS, RISK_PRICE_BAND, RISK_LOSS, RISK_CHECKS };
+
+static const char* const kRiskCheckNames[RISK_CHECKS] = {"max position", "max notional", "max open orders",
+                                                         "price band", "loss limit"};
+
+struct RiskStats {
+    uint64_t checks;
+    uint64_t rejected;
+    uint64_t failed[RISK_CHECKS];   // an order can fail several checks
+    double nsPerCheck;              // net of the clock's own cost
+};
+
+// -------------------------
+// Pre-trade risk checks
+// Every order is checked against max position, max notional and max open
+// orders for its instrument, a fat-finger band around the last market
+// price before the order's own, and its strategy's loss limit. The instrument is the strategy's
+// option structure. State is a few flat per-instrument counters in one
+// object, so a check is a handful of cache-resident loads and compares.
+// All five are evaluated together into a failure mask, with no early
+// exit. Orders that reduce a position skip the exposure and loss checks.
+// The engine times every check and reports the cost net of the clock
+// reads, measured once at construction.
+// -------------------------
+class RiskEngine {
+public:
+    // reference is the first market price, the band's initial centre
+    RiskEngine(const RiskParams& rp, double reference)
+        : maxPosition_(rp.maxPosition), maxOpenOrders_(rp.maxOpenOrders), maxNotional_(rp.maxNotional),
+          band_(rp.priceBandBps * 1e-4), maxLoss_(rp.maxLoss), reference_(reference), checks_(0), rejected_(0), ns_(0) {
+        for (int k = 0; k < 6; k++) {
+            position_[k] = 0;
+            openOrders_[k] = 0;
+            notional_[k] = 0.0;
+            realized_[k] = 0.0;
+        }
+        for (int c = 0; c < RISK_CHECKS; c++) failed_[c] = 0;
+        // Mean cost of a back-to-back pair of clock reads
+        uint64_t total = 0;
+        for (int i = 0; i < kClockSamples; i++) {
+            uint64_t a = nowNs();
+            total += nowNs() - a;
+        }
+        clockNs_ = (double)total / kClockSamples;
+    }
+
+    // Last traded price of the underlying, the centre of the price band.
+    // Callers check a tick's orders first and then pass its price, so an
+    // order priced off a jump is compared with the price before it.
+    void onMarket(double S) { reference_ = S; }
+
+    // Checks an order for `contracts` contracts of instrument k at `price`
+    // (side +1 opens, -1 closes); an approved order counts as open until
+    // its fill.
+    bool approve(int k, int side, int contracts, double price) {
+        uint64_t c0 = nowNs();
+        const unsigned opening = side > 0;
+        unsigned fail = (opening & (position_[k] + contracts > maxPosition_)) << RISK_POSITION
+                      | (opening & (notional_[k] + contracts * price > maxNotional_)) << RISK_NOTIONAL
+                      | (unsigned)(openOrders_[k] >= maxOpenOrders_) << RISK_OPEN_ORDERS
+                      | (unsigned)(std::fabs(price - reference_) > band_ * reference_) << RISK_PRICE_BAND
+                      | (opening & (realized_[k] < -maxLoss_)) << RISK_LOSS;
+        for (int c = 0; c < RISK_CHECKS; c++) failed_[c] += (fail >> c) & 1u;
+        openOrders_[k] += fail == 0;
+        rejected_ += fail != 0;
+        checks_++;
+        ns_ += nowNs() - c0;
+        return fail == 0;
+    }
+
+    // An approved order filled; realizedPnL is the strategy's realised PnL
+    // after the fill
+    void onFill(int k, int side, int contracts, double price, double realizedPnL) {
+        openOrders_[k]--;
+        if (side > 0) {
+            notional_[k] += contracts * price;
+            position_[k] += contracts;
+        } else {
+            int left = std::max(position_[k] - contracts, 0);
+            notional_[k] = position_[k] ? notional_[k] * left / position_[k] : 0.0;
+            position_[k] = left;
+        }
+        realized_[k] = realizedPnL;
+    }
+
+    // A position closed without an order (options expiring)
+    void onSettle(int k, int contracts, double realizedPnL) {
+        int left = std::max(position_[k] - contracts, 0);
+        notional_[k] = position_[k] ? notional_[k] * left / position_[k] : 0.0;
+        position_[k] = left;
+        realized_[k] = realizedPnL;
+    }
+
+    // An approved order that will not fill (rejected downstream)
+    void onCancel(int k) { openOrders_[k]--; }
+
+    RiskStats stats() const {
+        RiskStats s;
+        s.checks = checks_;
+        s.rejected = rejected_;
+        for (int c = 0; c < RISK_CHECKS; c++) s.failed[c] = failed_[c];
+        s.nsPerCheck = checks_ ? std::max((double)ns_ / checks_ - clockNs_, 0.0) : 0.0;
+        return s;
+    }
+
+private:
+    static const int kClockSamples = 1000;
+
+    static uint64_t nowNs() {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // Limits
+    int maxPosition_;        // contracts per instrument
+    int maxOpenOrders_;      // per instrument
+    double maxNotional_;     // contracts x underlying, per instrument
+    double band_;            // fraction of the reference price
+    double maxLoss_;         // realised loss per strategy
+    // Per-instrument state, indexed by strategy 1..5
+    int position_[6];
+    int openOrders_[6];
+    double notional_[6];
+    double realized_[6];
+    double reference_;
+    // Accounting
+    uint64_t checks_;
+    uint64_t rejected_;
+    uint64_t failed_[RISK_CHECKS];
+    uint64_t ns_;
+    double clockNs_;
+};
+
+#endif // RISK_H
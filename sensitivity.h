@@ -0,0 +1,327 @@
+#ifndef SENSITIVITY_H
+#define SENSITIVITY_H
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include "aad.h"
+#include "arena.h"
+#include "config.h"
+#include "expiry.h"
+#include "indicators.h"
+#include "simulation.h"
+#include "strategies.h"
+
+// Inputs the strategy replay is differentiated in: the model's, shared by
+// every strategy, and each strategy's own
+enum ModelInput { IN_S0 = 0, IN_MU, IN_SIGMA, MODEL_INPUTS };
+enum StrategyInput { IN_STRIKE_OFFSET = 0, IN_ENTRY, IN_EXIT, IN_FEE, IN_SLIPPAGE, IN_IMPACT, STRATEGY_INPUTS };
+
+static const char* const kModelInputNames[MODEL_INPUTS] = {"S0", "mu", "sigma"};
+static const char* const kStrategyInputNames[STRATEGY_INPUTS] = {
+    "strike offset", "entry threshold", "exit threshold", "fee per fill", "slippage per price", "impact per price"};
+
+// Inputs of the European option priced alongside
+enum OptionInput { OPT_SPOT = 0, OPT_STRIKE, OPT_MATURITY, OPT_SIGMA, OPT_RATE, OPTION_INPUTS };
+
+static const char* const kOptionInputNames[OPTION_INPUTS] = {"spot", "strike", "maturity", "sigma", "rate"};
+
+template <class T>
+struct StrategyInputs {
+    T model[MODEL_INPUTS];
+    T strategy[6][STRATEGY_INPUTS];   // index 1..5, slot 0 unused
+};
+
+inline StrategyInputs<double> strategyInputs(const SimParams& p) {
+    StrategyInputs<double> in;
+    in.model[IN_S0] = p.model.S0;
+    in.model[IN_MU] = p.model.mu;
+    in.model[IN_SIGMA] = p.model.sigma;
+    for (int k = 0; k < 6; k++) {
+        const StrategyParams& sp = p.strategy[k];
+        in.strategy[k][IN_STRIKE_OFFSET] = sp.strikeOffset;
+        in.strategy[k][IN_ENTRY] = sp.entryThreshold;
+        in.strategy[k][IN_EXIT] = sp.exitThreshold;
+        in.strategy[k][IN_FEE] = sp.feePerFill;
+        in.strategy[k][IN_SLIPPAGE] = sp.slippagePerPrice;
+        in.strategy[k][IN_IMPACT] = sp.impactPerPrice;
+    }
+    return in;
+}
+
+// Logistic step of x over `width`; the hard step x > 0 at width 0. Far
+// out in either tail it is the constant 0 or 1, so nothing is recorded.
+template <class T>
+inline T smoothStep(const T& x, double width) {
+    using std::exp;
+    if (width == 0.0) return T(x > 0.0 ? 1.0 : 0.0);
+    const T z = x / width;
+    if (z > 40.0) return T(1.0);
+    if (z < -40.0) return T(0.0);
+    return 1.0 / (1.0 + exp(-z));
+}
+
+// Part of a strategy's position opened on one tick
+template <class T>
+struct Cohort {
+    T weight;
+    T K[3];
+    int entryTick;
+};
+
+// -------------------------
+// Smoothed strategy replay
+// The single-path simulation (SMA crossover, window volatility, no chain,
+// risk checks or expiries) written once for any number type. Prices
+// follow GBM on the given shocks and every indicator is recomputed from
+// them. Each signal comparison becomes a logistic step whose width is
+// `smoothing` model tick volatilities (the crossover is taken relative to
+// the long MA), so a strategy holds a weight between 0 and 1 rather than
+// a trade. The weight is split into cohorts by entry tick, each keeping
+// its strikes: a tick opens enter x the weight that was flat, and closes
+// exit x each cohort, and all of any cohort that has reached the holding
+// period. Payoffs and fill costs are booked in proportion. With smoothing
+// 0 every weight is 0 or 1 and the replay is the simulation, tick for
+// tick and bit for bit; with smoothing > 0, PnL is smooth in the
+// thresholds too.
+// -------------------------
+template <class T>
+inline void replayStrategies(const SimParams& p, const StrategyInputs<T>& in, const double* shocks,
+                             double smoothing, double prune, Arena& arena, T pnl[6]) {
+    const std::size_t mark = arena.mark();
+    const int n = p.totalTicks;
+    T* prices = arena.allocArray<T>(n);
+    prices[0] = in.model[IN_S0];
+    for (int t = 1; t < n; t++) prices[t] = gbmStep(prices[t - 1], in.model[IN_MU], in.model[IN_SIGMA], p.model.dt, shocks[t]);
+
+    const double tickVol = smoothing * p.model.sigma * std::sqrt(p.model.dt);
+    Cohort<T>* cohorts[6];
+    int live[6];
+    for (int k = 0; k < 6; k++) {
+        pnl[k] = T(0.0);
+        live[k] = 0;
+        cohorts[k] = k ? arena.allocArray<Cohort<T> >(std::max(p.strategy[k].holdPeriod, 1) + 1) : nullptr;
+    }
+
+    for (int t = 1; t < n; t++) {
+        const T shortMA = computeMA(prices, t, p.shortWindow);
+        const T longMA = computeMA(prices, t, p.longWindow);
+        const T vol = computeVolatility(prices, t, p.volWindow, arena);
+        const T& S = prices[t];
+        for (int k = 1; k <= 5; k++) {
+            const StrategyParams& sp = p.strategy[k];
+            if (!sp.enabled) continue;
+            const T* x = in.strategy[k];
+
+            // ----- Signals, as signalKernel's comparisons -----
+            T enter, exit;
+            if (k == BULL || k == BEAR) {
+                const T gap = (shortMA - longMA) / longMA;
+                enter = smoothStep(k == BULL ? gap : -gap, tickVol);
+                exit = 1.0 - enter;
+            } else if (k == BUTTERFLY) {
+                enter = smoothStep(x[IN_ENTRY] - vol, tickVol);
+                exit = smoothStep(vol - x[IN_EXIT], tickVol) * (1.0 - enter);
+            } else {
+                enter = smoothStep(vol - x[IN_ENTRY], tickVol);
+                exit = smoothStep(x[IN_EXIT] - vol, tickVol) * (1.0 - enter);
+            }
+
+            // ----- Entries come out of what was flat before this tick -----
+            T flat = 1.0;
+            for (int c = 0; c < live[k]; c++) flat -= cohorts[k][c].weight;
+            const T opening = flat * enter;
+
+            // ----- Exits, costs charged as chargeFill does -----
+            int kept = 0;
+            for (int c = 0; c < live[k]; c++) {
+                Cohort<T>& co = cohorts[k][c];
+                const T closing = t - co.entryTick >= sp.holdPeriod ? co.weight : co.weight * exit;
+                if (valueOf(closing) > 0.0) {
+                    pnl[k] += closing * (structurePayoff(k, S, co.K) * sp.volume);
+                    pnl[k] -= closing * (x[IN_FEE] + x[IN_SLIPPAGE] * S + x[IN_IMPACT] * S);
+                    co.weight -= closing;
+                }
+                if (t - co.entryTick < sp.holdPeriod && valueOf(co.weight) > prune) cohorts[k][kept++] = co;
+            }
+            live[k] = kept;
+
+            if (valueOf(opening) > prune) {
+                Cohort<T>& co = cohorts[k][live[k]++];
+                co.weight = opening;
+                co.entryTick = t;
+                structureStrikes(k, S, x[IN_STRIKE_OFFSET], co.K);
+                pnl[k] -= opening * (x[IN_FEE] + x[IN_SLIPPAGE] * S + x[IN_IMPACT] * S);
+            }
+        }
+    }
+    arena.rewind(mark);
+}
+
+struct SensitivityResult {
+    double pnl[6];                            // smoothed replay
+    double hardPnL[6];                        // replay with hard signals
+    double model[6][MODEL_INPUTS];            // d pnl[k] / d model input
+    double strategy[6][STRATEGY_INPUTS];      // d pnl[k] / d strategy k's own inputs
+    std::size_t tapeNodes;
+    double forwardMs;                         // one plain smoothed replay
+    double tapedMs;                           // the replay recording the tape
+    double reverseMs;                         // the vector reverse sweep
+    int bumpRuns;                             // replays for the bump check (0 = off)
+    double bumpMs;
+    double bumpError;                         // max |AAD - bump| / max(|AAD|, 1)
+    double option;                            // European option value
+    double optionAdjoint[OPTION_INPUTS];
+};
+
+// -------------------------
+// Adjoint sensitivities
+// One taped replay of the strategies and one reverse sweep, with an
+// adjoint lane per strategy seeded at its PnL, give every strategy's PnL
+// sensitivity to every input; the same for the European option of [lsm]
+// (spot, strike, maturity, sigma and rate) through the templated
+// Black-Scholes value. Optionally each input is also bumped up and down
+// and the plain replay rerun, as a check on the adjoints and a measure of
+// what they save.
+// -------------------------
+class SensitivityEngine {
+public:
+    SensitivityEngine(const SimParams& p, Arena& arena, uint64_t seed)
+        : p_(p), arena_(arena), tape_(tapeCapacity(p), arena, kLanes) {
+        shocks_ = arena.allocArray<double>(p.totalTicks);
+        std::default_random_engine generator((unsigned)seed);
+        std::normal_distribution<double> distribution(0.0, 1.0);
+        shocks_[0] = 0.0;
+        for (int t = 1; t < p.totalTicks; t++) shocks_[t] = distribution(generator);
+    }
+
+    // Nodes per tick: the GBM step, both MAs and the volatility window,
+    // then per enabled strategy its signals and about 16 per live cohort
+    // (at most holdPeriod + 1)
+    static std::size_t tapeCapacity(const SimParams& p) {
+        if (p.aad.tapeNodes) return p.aad.tapeNodes;
+        std::size_t perTick = 16 + p.shortWindow + p.longWindow + 8 * (std::size_t)p.volWindow;
+        for (int k = 1; k <= 5; k++)
+            if (p.strategy[k].enabled) perTick += 16 + 16 * (std::size_t)(std::max(p.strategy[k].holdPeriod, 1) + 1);
+        return perTick * p.totalTicks + 1024;
+    }
+
+    static std::size_t arenaBytes(const SimParams& p) {
+        std::size_t cohorts = 0;
+        for (int k = 1; k <= 5; k++) cohorts += (std::size_t)std::max(p.strategy[k].holdPeriod, 1) + 1;
+        return Tape::arenaBytes(tapeCapacity(p), kLanes) + (std::size_t)p.totalTicks * (sizeof(double) + sizeof(Adouble))
+               + cohorts * sizeof(Cohort<Adouble>) + (std::size_t)p.volWindow * sizeof(Adouble) + 16 * 64;
+    }
+
+    SensitivityResult run() {
+        typedef std::chrono::steady_clock Clock;
+        const AadParams& ap = p_.aad;
+        SensitivityResult r;
+        const StrategyInputs<double> base = strategyInputs(p_);
+
+        replayStrategies(p_, base, shocks_, 0.0, 0.0, arena_, r.hardPnL);
+        Clock::time_point c0 = Clock::now();
+        replayStrategies(p_, base, shocks_, ap.smoothing, ap.prune, arena_, r.pnl);
+        r.forwardMs = msSince(c0);
+
+        // ----- Taped replay, then one reverse sweep for all strategies -----
+        // The first pass faults in the tape's pages, the second is timed
+        StrategyInputs<Adouble> in;
+        Adouble pnl[6];
+        for (int pass = 0; pass < 2; pass++) {
+            tape_.clear();
+            for (int i = 0; i < MODEL_INPUTS; i++) in.model[i] = Adouble::input(base.model[i], tape_);
+            for (int k = 0; k < 6; k++)
+                for (int i = 0; i < STRATEGY_INPUTS; i++)
+                    in.strategy[k][i] = k ? Adouble::input(base.strategy[k][i], tape_) : Adouble(base.strategy[k][i]);
+            c0 = Clock::now();
+            replayStrategies(p_, in, shocks_, ap.smoothing, ap.prune, arena_, pnl);
+            r.tapedMs = msSince(c0);
+            if (pass == 0) reverse(pnl);   // and the adjoints'
+        }
+        r.tapeNodes = tape_.size();
+        c0 = Clock::now();
+        reverse(pnl);
+        for (int i = 0; i < MODEL_INPUTS; i++) r.model[0][i] = 0.0;
+        for (int i = 0; i < STRATEGY_INPUTS; i++) r.strategy[0][i] = 0.0;
+        for (int k = 1; k <= 5; k++) {
+            for (int i = 0; i < MODEL_INPUTS; i++) r.model[k][i] = tape_.adjoint(in.model[i].node(), k - 1);
+            for (int i = 0; i < STRATEGY_INPUTS; i++) r.strategy[k][i] = tape_.adjoint(in.strategy[k][i].node(), k - 1);
+        }
+        r.reverseMs = msSince(c0);
+
+        // ----- Bump and revalue every input -----
+        r.bumpRuns = 0;
+        r.bumpError = 0.0;
+        c0 = Clock::now();
+        if (ap.check) {
+            for (int k = 0; k <= 5; k++) {
+                const int inputs = k ? (int)STRATEGY_INPUTS : (int)MODEL_INPUTS;
+                for (int i = 0; i < inputs; i++) {
+                    double d[6];
+                    bump(base, k, i, d);
+                    r.bumpRuns += 2;
+                    for (int j = 1; j <= 5; j++) {
+                        if (k && j != k) continue;
+                        const double a = k ? r.strategy[k][i] : r.model[j][i];
+                        r.bumpError = std::max(r.bumpError, std::fabs(a - d[j]) / std::max(std::fabs(a), 1.0));
+                    }
+                }
+            }
+        }
+        r.bumpMs = msSince(c0);
+
+        // ----- European option of [lsm] -----
+        tape_.clear();
+        const LsmParams& lp = p_.lsm;
+        Adouble x[OPTION_INPUTS];
+        x[OPT_SPOT] = Adouble::input(p_.model.S0, tape_);
+        x[OPT_STRIKE] = Adouble::input(lp.strike, tape_);
+        x[OPT_MATURITY] = Adouble::input(lp.maturity, tape_);
+        x[OPT_SIGMA] = Adouble::input(p_.model.sigma, tape_);
+        x[OPT_RATE] = Adouble::input(lp.rate, tape_);
+        Adouble v = europeanValue(x[OPT_SPOT], x[OPT_STRIKE], x[OPT_MATURITY], x[OPT_SIGMA], x[OPT_RATE], lp.isCall != 0);
+        tape_.reverse(v.node());
+        r.option = v.value();
+        for (int i = 0; i < OPTION_INPUTS; i++) r.optionAdjoint[i] = tape_.adjoint(x[i].node());
+        return r;
+    }
+
+private:
+    static const int kLanes = 5;   // one adjoint lane per strategy
+
+    void reverse(const Adouble (&pnl)[6]) {
+        int outputs[kLanes];
+        for (int k = 1; k <= 5; k++) outputs[k - 1] = pnl[k].node();
+        tape_.reverse(outputs);
+    }
+
+    static double msSince(std::chrono::steady_clock::time_point c0) {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - c0).count();
+    }
+
+    // Central difference of every strategy's PnL in model input i (k = 0)
+    // or strategy k's input i
+    void bump(const StrategyInputs<double>& base, int k, int i, double d[6]) {
+        StrategyInputs<double> up = base, down = base;
+        double& xu = k ? up.strategy[k][i] : up.model[i];
+        double& xd = k ? down.strategy[k][i] : down.model[i];
+        const double h = 1e-6 * std::max(std::fabs(xu), 1e-3);
+        xu += h;
+        xd -= h;
+        double pu[6], pd[6];
+        replayStrategies(p_, up, shocks_, p_.aad.smoothing, p_.aad.prune, arena_, pu);
+        replayStrategies(p_, down, shocks_, p_.aad.smoothing, p_.aad.prune, arena_, pd);
+        for (int j = 0; j < 6; j++) d[j] = (pu[j] - pd[j]) / (2.0 * h);
+    }
+
+    const SimParams& p_;
+    Arena& arena_;
+    Tape tape_;
+    double* shocks_;   // the normals runSimulation draws for the seed
+};
+
+#endif // SENSITIVITY_H
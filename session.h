@@ -0,0 +1,653 @@
+#ifndef SESSION_H
+#define SESSION_H
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "arena.h"
+#include "config.h"
+#include "simulation.h"
+#include "strategies.h"
+
+// -------------------------
+// Order-entry messages
+// A session carries four messages: logon, new order, execution report and
+// logout, each with a sequence number per direction. Prices travel as
+// fixed-point integers in units of 1e-8, as in exchange binary protocols.
+// A codec encodes straight into the sender's buffer and decodes straight
+// out of the receive buffer; fields are read in place, never through an
+// intermediate copy or string.
+// -------------------------
+enum SessionMsgType { MSG_LOGON = 'A', MSG_NEW_ORDER = 'D', MSG_EXEC_REPORT = '8', MSG_LOGOUT = '5' };
+enum ExecStatus { EXEC_FILLED = 2, EXEC_REJECTED = 8 };   // FIX OrdStatus values
+
+static const double kSessionPriceScale = 1e8;
+static const int kSessionMaxMessage = 256;   // encoded size bound, either codec
+
+// Decoded view of one message; the fields a type does not use are zero
+struct SessionMsg {
+    int type;            // SessionMsgType
+    uint64_t seq;
+    uint64_t orderId;
+    int instrument;      // strategy 1..5
+    int side;            // +1 buy to open, -1 sell to close
+    int64_t price;       // limit price, or fill price in a report
+    uint32_t qty;        // contracts
+    int status;          // ExecStatus, reports only
+};
+
+inline SessionMsg sessionMsg(int type) {
+    SessionMsg m;
+    std::memset(&m, 0, sizeof(m));
+    m.type = type;
+    return m;
+}
+
+// -------------------------
+// Binary codec
+// Fixed-layout little structs in host byte order (both ends share the
+// box). Every message is a multiple of 8 bytes, so messages framed off the
+// front of an aligned receive buffer stay aligned and are read in place.
+// -------------------------
+struct BinHeader {
+    uint16_t length;     // whole message, bytes
+    uint8_t type;
+    uint8_t reserved;
+    uint32_t seq;
+};
+
+struct BinOrder {        // new order and execution report
+    BinHeader h;
+    uint64_t orderId;
+    int64_t price;
+    uint32_t qty;
+    uint8_t instrument;
+    int8_t side;
+    uint8_t status;
+    uint8_t reserved;
+};
+
+static_assert(sizeof(BinHeader) == 8 && sizeof(BinOrder) == 32, "binary messages must keep 8-byte sizes");
+
+struct BinaryCodec {
+    static const char* name() { return "binary"; }
+
+    // Encodes m into out (kSessionMaxMessage bytes); returns where the
+    // message starts and sets its length
+    static char* encode(char* out, const SessionMsg& m, std::size_t& len) {
+        bool order = m.type == MSG_NEW_ORDER || m.type == MSG_EXEC_REPORT;
+        len = order ? sizeof(BinOrder) : sizeof(BinHeader);
+        BinOrder* b = reinterpret_cast<BinOrder*>(out);
+        b->h.length = (uint16_t)len;
+        b->h.type = (uint8_t)m.type;
+        b->h.reserved = 0;
+        b->h.seq = (uint32_t)m.seq;
+        if (order) {
+            b->orderId = m.orderId;
+            b->price = m.price;
+            b->qty = m.qty;
+            b->instrument = (uint8_t)m.instrument;
+            b->side = (int8_t)m.side;
+            b->status = (uint8_t)m.status;
+            b->reserved = 0;
+        }
+        return out;
+    }
+
+    // Length of the complete message at the front of in[0, n), 0 if more
+    // bytes are needed
+    static std::size_t frame(const char* in, std::size_t n) {
+        if (n < sizeof(BinHeader)) return 0;
+        std::size_t len = reinterpret_cast<const BinHeader*>(in)->length;
+        if (len < sizeof(BinHeader) || len > (std::size_t)kSessionMaxMessage || len % 8)
+            throw std::runtime_error("malformed binary message length");
+        return n >= len ? len : 0;
+    }
+
+    static void decode(const char* in, std::size_t len, SessionMsg& m) {
+        const BinOrder* b = reinterpret_cast<const BinOrder*>(in);
+        m = sessionMsg(b->h.type);
+        m.seq = b->h.seq;
+        if (len < sizeof(BinOrder)) return;
+        m.orderId = b->orderId;
+        m.price = b->price;
+        m.qty = b->qty;
+        m.instrument = b->instrument;
+        m.side = b->side;
+        m.status = b->status;
+    }
+};
+
+// -------------------------
+// FIX-lite codec
+// FIX 4.4 tag=value framing with BodyLength and CheckSum, and only the
+// fields this session uses: MsgType, MsgSeqNum, ClOrdID, Symbol (the
+// instrument number), Side, OrderQty/LastQty, Price/LastPx and OrdStatus.
+// One connection is one session, so CompIDs and SendingTime are left
+// out. The body is written first and the header backwards in front of it,
+// so BodyLength is known without a second pass or a copy.
+// -------------------------
+struct FixCodec {
+    static const char SOH = '\x01';
+    static const int kHeaderRoom = 24;   // "8=FIX.4.4|9=nnnnn|"
+
+    static const char* name() { return "fix"; }
+
+    static char* encode(char* out, const SessionMsg& m, std::size_t& len) {
+        char* body = out + kHeaderRoom;
+        char* p = body;
+        p = put(p, "35=");
+        *p++ = (char)m.type;
+        *p++ = SOH;
+        p = putUint(put(p, "34="), m.seq);
+        if (m.type == MSG_LOGON) {
+            p = put(p, "98=0\x01" "108=30\x01");
+        } else if (m.type == MSG_NEW_ORDER || m.type == MSG_EXEC_REPORT) {
+            bool report = m.type == MSG_EXEC_REPORT;
+            p = putUint(put(p, "11="), m.orderId);
+            if (report) {
+                p = put(p, m.status == EXEC_FILLED ? "150=F\x01" "39=2\x01" : "150=8\x01" "39=8\x01");
+            }
+            p = putUint(put(p, "55="), (uint64_t)m.instrument);
+            p = put(p, m.side > 0 ? "54=1\x01" : "54=2\x01");
+            p = putUint(put(p, report ? "32=" : "38="), m.qty);
+            if (!report) p = put(p, "40=2\x01");
+            p = putPrice(put(p, report ? "31=" : "44="), m.price);
+        }
+
+        // Header, right to left: "8=FIX.4.4|9=<body length>|"
+        char* h = body;
+        *--h = SOH;
+        for (std::size_t n = (std::size_t)(p - body); ; n /= 10) {
+            *--h = (char)('0' + n % 10);
+            if (n < 10) break;
+        }
+        h -= 2;
+        std::memcpy(h, "9=", 2);
+        h -= 10;
+        std::memcpy(h, "8=FIX.4.4\x01", 10);
+
+        unsigned sum = 0;
+        for (const char* c = h; c < p; c++) sum += (unsigned char)*c;
+        sum &= 255;
+        p = put(p, "10=");
+        *p++ = (char)('0' + sum / 100);
+        *p++ = (char)('0' + sum / 10 % 10);
+        *p++ = (char)('0' + sum % 10);
+        *p++ = SOH;
+        len = (std::size_t)(p - h);
+        return h;
+    }
+
+    static std::size_t frame(const char* in, std::size_t n) {
+        if (n < 13) return 0;
+        if (std::memcmp(in, "8=FIX.4.4\x01" "9=", 12) != 0) throw std::runtime_error("malformed FIX header");
+        std::size_t body = 0, i = 12;
+        for (; i < n && in[i] != SOH; i++) {
+            if (in[i] < '0' || in[i] > '9' || i > 17) throw std::runtime_error("malformed FIX BodyLength");
+            body = body * 10 + (std::size_t)(in[i] - '0');
+        }
+        if (i == n) return 0;
+        std::size_t len = i + 1 + body + 7;   // header, body, "10=nnn|"
+        if (len > (std::size_t)kSessionMaxMessage) throw std::runtime_error("FIX message too long");
+        return n >= len ? len : 0;
+    }
+
+    static void decode(const char* in, std::size_t len, SessionMsg& m) {
+        const char* end = in + len - 7;
+        unsigned sum = 0;
+        for (const char* c = in; c < end; c++) sum += (unsigned char)*c;
+        if (std::memcmp(end, "10=", 3) != 0
+            || (unsigned)((end[3] - '0') * 100 + (end[4] - '0') * 10 + (end[5] - '0')) != (sum & 255))
+            throw std::runtime_error("bad FIX CheckSum");
+
+        m = sessionMsg(0);
+        const char* p = (const char*)std::memchr(in + 12, SOH, len - 12) + 1;   // past BodyLength
+        while (p < end) {
+            int tag = 0;
+            for (; *p != '='; p++) tag = tag * 10 + (*p - '0');
+            const char* v = ++p;
+            while (*p != SOH) p++;
+            switch (tag) {
+            case 35: m.type = *v; break;
+            case 34: m.seq = getUint(v, p); break;
+            case 11: m.orderId = getUint(v, p); break;
+            case 55: m.instrument = (int)getUint(v, p); break;
+            case 54: m.side = *v == '1' ? +1 : -1; break;
+            case 38: case 32: m.qty = (uint32_t)getUint(v, p); break;
+            case 44: case 31: m.price = getPrice(v, p); break;
+            case 39: m.status = (int)getUint(v, p); break;
+            default: break;   // 8, 9, 40, 98, 108, 150
+            }
+            p++;
+        }
+    }
+
+private:
+    template <std::size_t N>
+    static char* put(char* p, const char (&s)[N]) {
+        std::memcpy(p, s, N - 1);
+        return p + N - 1;
+    }
+
+    static char* putUint(char* p, uint64_t v) {
+        char digits[20];
+        int n = 0;
+        do {
+            digits[n++] = (char)('0' + v % 10);
+            v /= 10;
+        } while (v);
+        while (n) *p++ = digits[--n];
+        *p++ = SOH;
+        return p;
+    }
+
+    // Fixed point to "integer.8 digits"
+    static char* putPrice(char* p, int64_t v) {
+        uint64_t u = (uint64_t)std::max<int64_t>(v, 0);
+        p = putUint(p, u / 100000000) - 1;
+        *p++ = '.';
+        uint64_t frac = u % 100000000;
+        for (int i = 7; i >= 0; i--) {
+            p[i] = (char)('0' + frac % 10);
+            frac /= 10;
+        }
+        p += 8;
+        *p++ = SOH;
+        return p;
+    }
+
+    static uint64_t getUint(const char* v, const char* end) {
+        uint64_t x = 0;
+        for (; v < end; v++) x = x * 10 + (uint64_t)(*v - '0');
+        return x;
+    }
+
+    static int64_t getPrice(const char* v, const char* end) {
+        int64_t x = 0;
+        int decimals = -1;
+        for (; v < end; v++) {
+            if (*v == '.') decimals = 0;
+            else {
+                x = x * 10 + (*v - '0');
+                if (decimals >= 0) decimals++;
+            }
+        }
+        for (decimals = std::max(decimals, 0); decimals < 8; decimals++) x *= 10;
+        return x;
+    }
+};
+
+// -------------------------
+// Session channel
+// One end of the TCP connection. Sends are encoded into a fixed buffer
+// and written at once; received bytes accumulate in another, and complete
+// messages are framed and decoded off the front. A partial message is only
+// moved back to the start when the buffer runs out. Sequence numbers are
+// stamped on send and checked on receipt.
+// -------------------------
+template <class Codec>
+class SessionChannel {
+public:
+    SessionChannel(Arena& arena, std::size_t bytes)
+        : fd_(-1), send_(arena.allocArray<char>(kSessionMaxMessage)), recv_(arena.allocArray<char>(bytes)),
+          size_(bytes), head_(0), tail_(0), seqOut_(0), seqIn_(0), bytesOut_(0), bytesIn_(0) {}
+
+    SessionChannel(const SessionChannel&) = delete;
+    SessionChannel& operator=(const SessionChannel&) = delete;
+
+    void attach(int fd) {
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+        fd_ = fd;
+    }
+
+    int fd() const { return fd_; }
+    uint64_t bytesOut() const { return bytesOut_; }
+    uint64_t bytesIn() const { return bytesIn_; }
+
+    // Stamps the next sequence number on m and writes it out
+    void send(SessionMsg& m) {
+        m.seq = ++seqOut_;
+        std::size_t len;
+        const char* msg = Codec::encode(send_, m, len);
+        for (std::size_t done = 0; done < len;) {
+            ssize_t n = ::send(fd_, msg + done, len - done, MSG_NOSIGNAL);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) throw std::runtime_error("session send failed");
+            done += (std::size_t)n;
+        }
+        bytesOut_ += len;
+    }
+
+    // Blocks for the next message; false when the peer closed the connection
+    bool receive(SessionMsg& m) {
+        for (;;) {
+            std::size_t len = Codec::frame(recv_ + head_, tail_ - head_);
+            if (len) {
+                Codec::decode(recv_ + head_, len, m);
+                head_ += len;
+                if (m.seq != ++seqIn_) throw std::runtime_error("session sequence gap");
+                return true;
+            }
+            if (head_ == tail_) {
+                head_ = tail_ = 0;
+            } else if (tail_ == size_) {
+                std::memmove(recv_, recv_ + head_, tail_ - head_);
+                tail_ -= head_;
+                head_ = 0;
+            }
+            ssize_t n = ::recv(fd_, recv_ + tail_, size_ - tail_, 0);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) return false;
+            tail_ += (std::size_t)n;
+            bytesIn_ += (uint64_t)n;
+        }
+    }
+
+private:
+    int fd_;
+    char* send_;      // one encoded message
+    char* recv_;      // received bytes, [head_, tail_) not yet decoded
+    std::size_t size_;
+    std::size_t head_, tail_;
+    uint64_t seqOut_, seqIn_;
+    uint64_t bytesOut_, bytesIn_;
+};
+
+// -------------------------
+// Matching-engine stand-in
+// Listens on loopback and serves one session on its own thread: answers
+// the logon, fills every well-formed order in full at its limit price
+// (rejecting the rest) and acknowledges the logout. It keeps no book; it
+// exists so the client pays the real encode, syscall, loopback and decode
+// costs of a round trip.
+// -------------------------
+template <class Codec>
+class MatchingEngineStub {
+public:
+    MatchingEngineStub(const SessionParams& sp, Arena& arena) : channel_(arena, sp.bufferBytes), listen_(-1) {
+        listen_ = socket(AF_INET, SOCK_STREAM, 0);
+        if (listen_ < 0) throw std::runtime_error("cannot create engine socket");
+        int one = 1;
+        setsockopt(listen_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        sockaddr_in addr;
+        std::memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = htons((uint16_t)sp.port);
+        socklen_t alen = sizeof(addr);
+        if (bind(listen_, (sockaddr*)&addr, sizeof(addr)) != 0 || listen(listen_, 1) != 0
+            || getsockname(listen_, (sockaddr*)&addr, &alen) != 0) {
+            close(listen_);
+            throw std::runtime_error("cannot listen on 127.0.0.1:" + std::to_string(sp.port));
+        }
+        port_ = ntohs(addr.sin_port);
+    }
+
+    ~MatchingEngineStub() {
+        if (channel_.fd() >= 0) close(channel_.fd());
+        close(listen_);
+    }
+
+    int port() const { return port_; }
+
+    // Thread body: one session, until logout or disconnect
+    void serve() {
+        int fd = accept(listen_, nullptr, nullptr);
+        if (fd < 0) return;
+        channel_.attach(fd);
+        try {
+            SessionMsg in;
+            while (channel_.receive(in)) {
+                if (in.type == MSG_NEW_ORDER) {
+                    SessionMsg r = sessionMsg(MSG_EXEC_REPORT);
+                    r.orderId = in.orderId;
+                    r.instrument = in.instrument;
+                    r.side = in.side;
+                    r.price = in.price;
+                    bool valid = in.instrument >= 1 && in.instrument <= 5 && in.qty > 0 && in.price > 0;
+                    r.status = valid ? EXEC_FILLED : EXEC_REJECTED;
+                    r.qty = valid ? in.qty : 0;
+                    channel_.send(r);
+                } else if (in.type == MSG_LOGON || in.type == MSG_LOGOUT) {
+                    SessionMsg r = sessionMsg(in.type);
+                    channel_.send(r);
+                    if (in.type == MSG_LOGOUT) break;
+                }
+            }
+        } catch (const std::exception&) {
+            // Malformed input: drop the connection, the client sees it closed
+        }
+        shutdown(fd, SHUT_RDWR);
+    }
+
+private:
+    SessionChannel<Codec> channel_;
+    int listen_;
+    int port_;
+};
+
+struct SessionStats {
+    const char* encoding;
+    int port;
+    uint64_t orders;
+    uint64_t rejected;        // by the engine
+    uint64_t bytesOut;        // client to engine, including logon and logout
+    uint64_t bytesIn;
+    double orderBytes;        // encoded new order
+    double reportBytes;       // encoded execution report
+    double encodeNs;          // per message, new order and report alternately
+    double decodeNs;
+    double meanRttNs, p50RttNs, p99RttNs, maxRttNs;   // send of an order to its decoded report
+    double ms;                // whole session, logon to logout
+};
+
+// -------------------------
+// Order-entry session
+// Signals for the path are computed up front; the client then walks the
+// ticks and takes the decisions of executeStrategies, but every open and
+// close goes to the matching engine as a new order over TCP and is booked
+// only when its fill comes back. Orders go one at a time, so each round
+// trip is timed on its own, and fills are at the decision price, so PnL
+// equals single mode (config rejects the option chain, whose listed
+// strikes the session does not use). Afterwards the codec alone is timed
+// over the session's message types.
+// -------------------------
+template <class Codec>
+class OrderSession {
+public:
+    OrderSession(const SimParams& p, SimMemory& mem, uint64_t seed)
+        : p_(p), mem_(mem), engine_(p.session, mem.arena), channel_(mem.arena, p.session.bufferBytes) {
+        const int n = p.totalTicks;
+        prices_ = mem.arena.allocArray<double>(n);
+        signals_ = mem.arena.allocArray<SignalMask>(n);
+        rtt_ = mem.arena.allocArray<double>(maxOrders(p));
+        generatePath(p.model, seed, prices_, n);
+        computeSignals(p, mem, prices_, n, signals_);
+        book_.risk = makeRiskEngine(p, mem.arena, prices_[0]);
+    }
+
+    // Every strategy can send at most one order per tick
+    static std::size_t maxOrders(const SimParams& p) { return 5 * (std::size_t)p.totalTicks; }
+
+    static std::size_t arenaBytes(const SimParams& p) {
+        return (std::size_t)p.totalTicks * (sizeof(double) + sizeof(SignalMask)) + maxOrders(p) * sizeof(double)
+               + 2 * ((std::size_t)p.session.bufferBytes + kSessionMaxMessage) + streamingBankArenaBytes(p, 1)
+               + sizeof(RiskEngine) + 16 * 64;
+    }
+
+    SimResult run(SessionStats& stats) {
+        std::memset(&stats, 0, sizeof(stats));
+        stats.encoding = Codec::name();
+        stats.port = engine_.port();
+        std::thread engine(&MatchingEngineStub<Codec>::serve, &engine_);
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        try {
+            sockaddr_in addr;
+            std::memset(&addr, 0, sizeof(addr));
+            addr.sin_family = AF_INET;
+            addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            addr.sin_port = htons((uint16_t)engine_.port());
+            if (fd < 0 || connect(fd, (sockaddr*)&addr, sizeof(addr)) != 0)
+                throw std::runtime_error("cannot connect to the matching engine");
+            channel_.attach(fd);
+            exchange(MSG_LOGON);
+            trade(stats);
+            exchange(MSG_LOGOUT);
+        } catch (...) {
+            if (fd >= 0) shutdown(fd, SHUT_RDWR);
+            engine.join();
+            if (fd >= 0) close(fd);
+            throw;
+        }
+        engine.join();
+        close(fd);
+        stats.ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        stats.bytesOut = channel_.bytesOut();
+        stats.bytesIn = channel_.bytesIn();
+
+        int timed = (int)stats.orders;
+        std::sort(rtt_, rtt_ + timed);
+        if (timed) {
+            double sum = 0;
+            for (int i = 0; i < timed; i++) sum += rtt_[i];
+            stats.meanRttNs = sum / timed;
+            stats.p50RttNs = rtt_[timed / 2];
+            stats.p99RttNs = rtt_[std::min(timed - 1, (int)(0.99 * timed))];
+            stats.maxRttNs = rtt_[timed - 1];
+        }
+        timeCodec(stats);
+
+        SimResult r;
+        r.loopAllocs = 0;
+        r.chainNsPerTick = 0.0;
+        r.markNsPerTick = 0.0;
+        r.risk = riskStats(book_.risk);
+        for (int i = 0; i < 6; i++) {
+            r.cumulativePnL[i] = book_.cumulativePnL[i];
+            r.tradeCount[i] = book_.tradeCount[i];
+            r.fees[i] = book_.fees[i];
+            r.slippage[i] = book_.slippage[i];
+            r.impact[i] = book_.impact[i];
+            r.openMark[i] = 0.0;
+            if (book_.active[i]) mem_.trades.release(book_.active[i]);
+            book_.active[i] = nullptr;
+        }
+        return r;
+    }
+
+private:
+    static uint64_t nowNs() {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    // Logon or logout: send it and wait for the engine's echo
+    void exchange(int type) {
+        SessionMsg m = sessionMsg(type), r;
+        channel_.send(m);
+        if (!channel_.receive(r) || r.type != type) throw std::runtime_error("session handshake failed");
+    }
+
+    // The decisions of executeStrategies, each fill waiting on the engine
+    void trade(SessionStats& stats) {
+        uint64_t nextId = 0;
+        for (int t = 1; t < p_.totalTicks; t++) {
+            double S = prices_[t];
+            SignalMask s = signals_[t];
+            for (int k = 1; k <= 5; k++) {
+                const Trade* tr = book_.active[k];
+                int side = 0;
+                if (!tr && signalEnter(s, k)) side = +1;
+                else if (tr && ((t - tr->entryTick >= p_.strategy[k].holdPeriod) || signalExit(s, k))) side = -1;
+                if (!side) continue;
+                // A rejected exit is retried on the next tick
+                if (book_.risk && !book_.risk->approve(k, side, orderContracts(p_, k), S)) continue;
+
+                SessionMsg o = sessionMsg(MSG_NEW_ORDER), r;
+                o.orderId = ++nextId;
+                o.instrument = k;
+                o.side = side;
+                o.price = std::llround(S * kSessionPriceScale);
+                o.qty = (uint32_t)orderContracts(p_, k);
+                uint64_t t0 = nowNs();
+                channel_.send(o);
+                if (!channel_.receive(r)) throw std::runtime_error("matching engine closed the session");
+                rtt_[stats.orders++] = (double)(nowNs() - t0);
+                if (r.type != MSG_EXEC_REPORT || r.orderId != o.orderId)
+                    throw std::runtime_error("unexpected message from the matching engine");
+                if (r.status != EXEC_FILLED || r.qty != o.qty || r.price != o.price) {
+                    stats.rejected++;
+                    if (book_.risk) book_.risk->onCancel(k);
+                    continue;
+                }
+                // Booked at the decision price, which the report echoes to 1e-8
+                if (side > 0) openTrade(p_, book_, mem_, k, t, S);
+                else closeTrade(p_, book_, mem_, k, t, S);
+            }
+            if (book_.risk) book_.risk->onMarket(S);   // the band centre for the next tick's orders
+        }
+    }
+
+    // Encode and decode cost per message, out of the session's own buffers
+    void timeCodec(SessionStats& stats) {
+        const int iterations = 100000;
+        char* buf = mem_.arena.allocArray<char>(2 * kSessionMaxMessage);
+        SessionMsg m[2] = {sessionMsg(MSG_NEW_ORDER), sessionMsg(MSG_EXEC_REPORT)};
+        for (int j = 0; j < 2; j++) {
+            m[j].seq = 1000 + j;
+            m[j].orderId = 500 + j;
+            m[j].instrument = 5;
+            m[j].side = +1;
+            m[j].price = std::llround(prices_[p_.totalTicks - 1] * kSessionPriceScale);
+            m[j].qty = 40;
+            m[j].status = EXEC_FILLED;
+        }
+        const char* start[2];
+        std::size_t len[2];
+        volatile uint64_t sink = 0;   // keeps the loops from being optimised away
+        uint64_t t0 = nowNs();
+        for (int i = 0; i < iterations; i++) {
+            int j = i & 1;
+            m[j].seq++;
+            start[j] = Codec::encode(buf + j * kSessionMaxMessage, m[j], len[j]);
+            sink = sink + len[j];
+        }
+        uint64_t t1 = nowNs();
+        SessionMsg d;
+        for (int i = 0; i < iterations; i++) {
+            int j = i & 1;
+            Codec::decode(start[j], Codec::frame(start[j], len[j]), d);
+            sink = sink + d.seq;
+        }
+        uint64_t t2 = nowNs();
+        stats.encodeNs = (double)(t1 - t0) / iterations;
+        stats.decodeNs = (double)(t2 - t1) / iterations;
+        stats.orderBytes = (double)len[0];
+        stats.reportBytes = (double)len[1];
+    }
+
+    const SimParams& p_;
+    SimMemory& mem_;
+    MatchingEngineStub<Codec> engine_;
+    SessionChannel<Codec> channel_;   // client end
+    StrategyBook book_;
+    double* prices_;
+    SignalMask* signals_;
+    double* rtt_;                     // per order, ns
+};
+
+#endif // SESSION_H
@@ -0,0 +1,175 @@
+#ifndef SHARDED_H
+#define SHARDED_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include "config.h"
+#include "pathcache.h"
+#include "simulation.h"
+
+// -------------------------
+// Sharded multi-process sweep runner
+// The parent maps one anonymous shared region, forks N workers and waits.
+// Work is a flat list of shards (a parameter set and a range of path
+// seeds), each set's shards contiguous and as many as its run.paths
+// needs; workers claim shards with an atomic counter in the shared
+// header and write per-strategy statistics straight into the shard's slot
+// of the shared results array, so nothing is serialized or locked. A
+// worker that dies leaves its shard unmarked and the parent reruns it,
+// overwriting whatever the dead worker left in the slot. Path caches
+// mapped before the fork are shared by every worker.
+// -------------------------
+struct ShardHeader {
+    std::atomic<uint64_t> nextShard;
+    uint64_t shardCount;
+    uint64_t pathsPerShard;
+    int sets;
+    int workers;
+};
+
+class ShardedRunner {
+public:
+    // caches: one per parameter set (entries may be null), or empty
+    ShardedRunner(const std::vector<SimParams>& sets, int workers, int pathsPerShard, uint64_t seed,
+                  const std::vector<const PathCache*>& caches = std::vector<const PathCache*>())
+        : sets_(sets), caches_(caches), seed_(seed), region_(nullptr), regionBytes_(0) {
+        uint64_t perShard = (uint64_t)(pathsPerShard > 0 ? pathsPerShard : 1);
+        uint64_t shardCount = 0;
+        for (size_t s = 0; s < sets.size(); s++) shardCount += ((uint64_t)sets[s].paths + perShard - 1) / perShard;
+
+        // Layout: header | first shard of each set, then shardCount |
+        // done flags (one per shard) | stats[shard][6]
+        firstOffset_ = align64(sizeof(ShardHeader));
+        doneOffset_ = align64(firstOffset_ + (sets.size() + 1) * sizeof(uint64_t));
+        statsOffset_ = align64(doneOffset_ + shardCount);
+        regionBytes_ = statsOffset_ + shardCount * 6 * sizeof(PnLStats);
+        region_ = mmap(nullptr, regionBytes_, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+        if (region_ == MAP_FAILED) throw std::runtime_error("cannot map shared results region");
+
+        header_ = new (region_) ShardHeader();
+        header_->nextShard.store(0);
+        header_->shardCount = shardCount;
+        header_->pathsPerShard = perShard;
+        header_->sets = (int)sets.size();
+        header_->workers = workers;
+        firstShard_ = reinterpret_cast<uint64_t*>(static_cast<char*>(region_) + firstOffset_);
+        firstShard_[0] = 0;
+        for (size_t s = 0; s < sets.size(); s++)
+            firstShard_[s + 1] = firstShard_[s] + ((uint64_t)sets[s].paths + perShard - 1) / perShard;
+        done_ = static_cast<unsigned char*>(region_) + doneOffset_;
+        stats_ = reinterpret_cast<PnLStats*>(static_cast<char*>(region_) + statsOffset_);
+        for (size_t i = 0; i < shardCount * 6; i++) new (&stats_[i]) PnLStats();
+    }
+
+    ~ShardedRunner() {
+        if (region_) munmap(region_, regionBytes_);
+    }
+
+    ShardedRunner(const ShardedRunner&) = delete;
+    ShardedRunner& operator=(const ShardedRunner&) = delete;
+
+    // Runs every shard; returns the number of workers that failed.
+    int run() {
+        int workers = header_->workers;
+        std::vector<pid_t> pids;
+        for (int w = 0; w < workers; w++) {
+            pid_t pid = fork();
+            if (pid < 0) throw std::runtime_error("fork failed");
+            if (pid == 0) {
+                int rc = 0;
+                try {
+                    workerLoop(true);
+                } catch (...) {
+                    rc = 1;
+                }
+                _exit(rc);
+            }
+            pids.push_back(pid);
+        }
+        int failed = 0;
+        for (size_t i = 0; i < pids.size(); i++) {
+            int status = 0;
+            waitpid(pids[i], &status, 0);
+            if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) failed++;
+        }
+        // Shards a dead worker claimed but never finished run here
+        if (failed) workerLoop(false);
+        return failed;
+    }
+
+    // Per-strategy statistics for parameter set s, merged across shards
+    PnLStats merged(int s, int strategy) const {
+        PnLStats total;
+        for (uint64_t i = firstShard_[s]; i < firstShard_[s + 1]; i++) total.merge(stats_[i * 6 + strategy]);
+        return total;
+    }
+
+    uint64_t shardCount() const { return header_->shardCount; }
+
+private:
+    static size_t align64(size_t n) { return (n + 63) & ~(size_t)63; }
+
+    // claimNew: take shards from the shared counter (workers); otherwise
+    // sweep for shards that are not marked done (parent recovery).
+    void workerLoop(bool claimNew) {
+        SimMemory* mem = nullptr;
+        int memSet = -1;
+        for (uint64_t i = 0;; i++) {
+            uint64_t shard;
+            if (claimNew) {
+                shard = header_->nextShard.fetch_add(1);
+                if (shard >= header_->shardCount) break;
+            } else {
+                if (i >= header_->shardCount) break;
+                if (done_[i]) continue;
+                shard = i;
+            }
+            int set = (int)(std::upper_bound(firstShard_, firstShard_ + header_->sets + 1, shard) - firstShard_) - 1;
+            const SimParams& p = sets_[set];
+            if (set != memSet) {
+                delete mem;
+                mem = new SimMemory(p.memory);
+                memSet = set;
+            }
+            uint64_t first = (shard - firstShard_[set]) * header_->pathsPerShard;
+            uint64_t last = first + header_->pathsPerShard;
+            if (last > (uint64_t)p.paths) last = (uint64_t)p.paths;
+
+            // Accumulate locally, publish once per shard
+            const PathCache* cache = set < (int)caches_.size() ? caches_[set] : nullptr;
+            PnLStats local[6];
+            for (uint64_t path = first; path < last; path++) {
+                SimResult r = runSimulation(p, *mem, seed_ + path, cache ? cache->path(path) : nullptr);
+                for (int k = 1; k <= 5; k++) local[k].add(r.cumulativePnL[k]);
+            }
+            PnLStats* out = stats_ + shard * 6;
+            for (int k = 0; k < 6; k++) out[k] = local[k];
+            std::atomic_thread_fence(std::memory_order_release);
+            done_[shard] = 1;
+        }
+        delete mem;
+    }
+
+    const std::vector<SimParams>& sets_;
+    std::vector<const PathCache*> caches_;
+    uint64_t seed_;
+    void* region_;
+    size_t regionBytes_;
+    size_t firstOffset_;
+    size_t doneOffset_;
+    size_t statsOffset_;
+    ShardHeader* header_;
+    uint64_t* firstShard_;    // [sets + 1]
+    unsigned char* done_;
+    PnLStats* stats_;
+};
+
+#endif // SHARDED_H
@@ -0,0 +1,563 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include "arena.h"
+#include "config.h"
+#include "expiry.h"
+#include "indicators.h"
+#include "lattice.h"
+#include "optionchain.h"
+#include "risk.h"
+#include "strategies.h"
+#include "telemetry.h"
+
+// Order sent to the (simulated) exchange on behalf of a strategy
+struct Order {
+    int strategyType;
+    int tick;
+    int side;            // +1 open, -1 close
+    double price;
+    int volume;
+    uint64_t arrivalNs;  // time it reached the matching engine
+    double queueAhead;   // volume ahead of a resting limit order
+    bool resting;        // resting in the book, waiting on the queue
+};
+
+// Per-simulation memory: one arena that backs the price path, the
+// object pools and per-tick scratch buffers. Everything is sized up
+// front so the steady-state tick loop never calls malloc.
+struct SimMemory {
+    Arena arena;
+    ObjectPool<Trade> trades;
+    ObjectPool<Order> orders;
+
+    explicit SimMemory(const MemoryConfig& cfg)
+        : arena(cfg.arenaBytes, cfg.hugePages),
+          trades(arena, cfg.tradePoolSize),
+          orders(arena, cfg.orderPoolSize) {}
+};
+
+// Per-run position book: the open trade of each strategy (nullptr when
+// flat), its realised PnL net of costs, and the costs paid. Indexed by
+// strategy type. With risk checks on, every order goes through `risk`;
+// with expiries on, every trade's options go through `lifecycle`.
+struct StrategyBook {
+    Trade* active[6];
+    double cumulativePnL[6];
+    int tradeCount[6];
+    double fees[6];
+    double slippage[6];   // half spread plus slippage
+    double impact[6];
+    RiskEngine* risk;
+    OptionLifecycle* lifecycle;
+    int underlying;       // asset index in multi mode
+
+    StrategyBook() : risk(nullptr), lifecycle(nullptr), underlying(0) {
+        for (int i = 0; i < 6; i++) {
+            active[i] = nullptr;
+            cumulativePnL[i] = 0;
+            tradeCount[i] = 0;
+            fees[i] = 0;
+            slippage[i] = 0;
+            impact[i] = 0;
+        }
+    }
+};
+
+// Charges one fill of strategy k at underlying price S: a multiply-add on
+// coefficients precomputed per strategy, all zero when costs are off.
+inline void chargeFill(StrategyBook& book, const StrategyParams& sp, int k, double S) {
+    double fee = sp.feePerFill;
+    double slip = sp.slippagePerPrice * S;
+    double impact = sp.impactPerPrice * S;
+    book.fees[k] += fee;
+    book.slippage[k] += slip;
+    book.impact[k] += impact;
+    book.cumulativePnL[k] -= fee + slip + impact;
+}
+
+struct SimResult {
+    double cumulativePnL[6];
+    int tradeCount[6];
+    std::size_t loopAllocs;   // heap allocations inside the tick loop
+    double chainNsPerTick;    // option-chain generation time (chain enabled)
+    double fees[6];           // transaction costs, included in cumulativePnL
+    double slippage[6];
+    double impact[6];
+    double openMark[6];       // American lattice value of positions still open
+    double markNsPerTick;     // lattice marking time (american enabled)
+    RiskStats risk;           // pre-trade checks (risk enabled)
+    ExpiryStats expiry;       // option lifecycle (expiry enabled)
+};
+
+// Contracts in one order of strategy k, the unit of the risk limits
+inline int orderContracts(const SimParams& p, int k) { return p.strategy[k].volume * kLegContracts[k]; }
+
+// Risk engine for a run, from the arena; nullptr when risk checks are off
+inline RiskEngine* makeRiskEngine(const SimParams& p, Arena& arena, double firstPrice) {
+    if (!p.risk.enabled) return nullptr;
+    RiskEngine* risk = static_cast<RiskEngine*>(arena.allocate(sizeof(RiskEngine), alignof(RiskEngine)));
+    return new (risk) RiskEngine(p.risk, firstPrice);
+}
+
+// Option lifecycle for a run, from the arena; nullptr without expiries
+inline OptionLifecycle* makeLifecycle(const SimParams& p, Arena& arena) {
+    if (!p.expiry.enabled) return nullptr;
+    OptionLifecycle* lc = static_cast<OptionLifecycle*>(arena.allocate(sizeof(OptionLifecycle), alignof(OptionLifecycle)));
+    return new (lc) OptionLifecycle(p, arena);
+}
+
+// Lifecycle totals, with the open positions of books[0..n) valued at
+// prices[underlying] on tick t; zeros without expiries
+inline ExpiryStats expiryStats(OptionLifecycle* lc, StrategyBook* books, int n, const double* prices, int t) {
+    ExpiryStats s;
+    std::memset(&s, 0, sizeof(s));
+    if (!lc) return s;
+    for (int i = 0; i < n; i++) lc->markOpen(books[i].active, prices[books[i].underlying], t);
+    return lc->stats();
+}
+
+inline RiskStats riskStats(const RiskEngine* risk) {
+    if (risk) return risk->stats();
+    RiskStats s;
+    s.checks = s.rejected = 0;
+    for (int c = 0; c < RISK_CHECKS; c++) s.failed[c] = 0;
+    s.nsPerCheck = 0.0;
+    return s;
+}
+
+// Running PnL statistics (Welford), mergeable across shards and threads
+struct PnLStats {
+    uint64_t n;
+    double mean;
+    double m2;     // sum of squared deviations from the mean
+    double min;
+    double max;
+
+    PnLStats() : n(0), mean(0), m2(0), min(HUGE_VAL), max(-HUGE_VAL) {}
+
+    void add(double x) {
+        n++;
+        double d = x - mean;
+        mean += d / n;
+        m2 += d * (x - mean);
+        min = x < min ? x : min;
+        max = x > max ? x : max;
+    }
+
+    // Chan et al. pairwise combination
+    void merge(const PnLStats& o) {
+        if (o.n == 0) return;
+        if (n == 0) {
+            *this = o;
+            return;
+        }
+        uint64_t total = n + o.n;
+        double d = o.mean - mean;
+        mean += d * o.n / total;
+        m2 += o.m2 + d * d * ((double)n * o.n / total);
+        n = total;
+        min = o.min < min ? o.min : min;
+        max = o.max > max ? o.max : max;
+    }
+
+    double stddev() const { return n ? std::sqrt(m2 / n) : 0.0; }
+};
+
+inline uint64_t resolveSeed(uint64_t seed) {
+    return seed ? seed : (uint64_t)std::chrono::system_clock::now().time_since_epoch().count();
+}
+
+// One GBM step from S with standard normal shock Z
+// Templated on the number type of the price and model parameters (aad.h)
+template <class T>
+inline T gbmStep(const T& S, const T& mu, const T& sigma, double dt, double Z) {
+    using std::exp;
+    return S * exp((mu - 0.5 * sigma * sigma) * dt + sigma * std::sqrt(dt) * Z);
+}
+
+inline double gbmStep(const ModelParams& m, double S, double Z) { return gbmStep(S, m.mu, m.sigma, m.dt, Z); }
+
+// Fills prices[0..n) with the GBM path runSimulation draws for this seed.
+inline void generatePath(const ModelParams& m, uint64_t seed, double* prices, int n) {
+    std::default_random_engine generator((unsigned)seed);
+    std::normal_distribution<double> distribution(0.0, 1.0);
+    prices[0] = m.S0;
+    for (int t = 1; t < n; t++) prices[t] = gbmStep(m, prices[t - 1], distribution(generator));
+}
+
+// -------------------------
+// Trade execution
+// Opens a trade on an entry signal when flat; otherwise closes the open
+// trade once the holding period is met or an exit signal fires. With an
+// option chain, strikes are snapped to the nearest listed strike.
+// -------------------------
+
+// Opens strategy k's trade at tick t, underlying S, paying the entry costs
+inline void openTrade(const SimParams& p, StrategyBook& book, SimMemory& mem, int k, int t, double S,
+                      const OptionChain* chain = nullptr) {
+    const StrategyParams& sp = p.strategy[k];
+    Trade* tr = book.active[k] = mem.trades.acquire();
+    tr->open = true;
+    tr->strategyType = k;
+    tr->entryTick = t;
+    tr->entryPrice = S;
+    setStrikes(*tr, S, sp.strikeOffset);
+    if (chain) {
+        tr->strike1 = chain->nearestStrike(tr->strike1);
+        tr->strike2 = chain->nearestStrike(tr->strike2);
+        tr->strike3 = chain->nearestStrike(tr->strike3);
+    }
+    tr->volume = sp.volume;
+    tr->expiryTick = 0;
+    tr->premium = 0.0;
+    tr->underlying = book.underlying;
+    if (book.lifecycle) book.lifecycle->open(tr, t, S);
+    chargeFill(book, sp, k, S);
+    if (book.risk) book.risk->onFill(k, +1, orderContracts(p, k), S, book.cumulativePnL[k]);
+}
+
+// Closes strategy k's open trade, realising its payoff net of exit costs
+inline void closeTrade(const SimParams& p, StrategyBook& book, SimMemory& mem, int k, int t, double S) {
+    Trade*& tr = book.active[k];
+    tr->exitTick = t;
+    tr->exitPrice = S;
+    tr->payoff = (book.lifecycle ? book.lifecycle->close(tr, t, S) : tradePayoff(*tr, S)) * tr->volume;
+    book.cumulativePnL[k] += tr->payoff;
+    book.tradeCount[k]++;
+    chargeFill(book, p.strategy[k], k, S);
+    tr->open = false;
+    mem.trades.release(tr);
+    tr = nullptr;
+    if (book.risk) book.risk->onFill(k, -1, orderContracts(p, k), S, book.cumulativePnL[k]);
+}
+
+// Cash-settles the trades expiring at tick t across books (one per asset,
+// sharing one lifecycle), each at prices[its underlying], then books the
+// theta of what stays open. Settlement pays no transaction costs.
+inline void settleExpiries(const SimParams& p, StrategyBook* books, int n, const double* prices, int t,
+                           SimMemory& mem) {
+    OptionLifecycle* lc = books[0].lifecycle;
+    for (Trade* tr = lc->expire(t); tr;) {
+        Trade* next = tr->wheelNext;
+        StrategyBook& book = books[tr->underlying];
+        const int k = tr->strategyType;
+        const double S = prices[tr->underlying];
+        tr->exitTick = t;
+        tr->exitPrice = S;
+        tr->payoff = lc->settle(*tr, S) * tr->volume;
+        book.cumulativePnL[k] += tr->payoff;
+        book.tradeCount[k]++;
+        tr->open = false;
+        mem.trades.release(tr);
+        book.active[k] = nullptr;
+        if (book.risk) book.risk->onSettle(k, orderContracts(p, k), book.cumulativePnL[k]);
+        tr = next;
+    }
+    for (int i = 0; i < n; i++) lc->mark(books[i].active, prices[i], t);
+}
+
+inline void executeStrategies(const SimParams& p, StrategyBook& book, SimMemory& mem,
+                              int t, double S, SignalMask signals,
+                              const OptionChain* chain = nullptr) {
+    RiskEngine* risk = book.risk;
+    for (int k = 1; k <= 5; k++) {
+        const Trade* tr = book.active[k];
+        if (!tr && signalEnter(signals, k)) {
+            if (!risk || risk->approve(k, +1, orderContracts(p, k), S)) openTrade(p, book, mem, k, t, S, chain);
+        } else if (tr && ((t - tr->entryTick >= p.strategy[k].holdPeriod) || signalExit(signals, k))) {
+            // A rejected exit is retried on the next tick
+            if (!risk || risk->approve(k, -1, orderContracts(p, k), S)) closeTrade(p, book, mem, k, t, S);
+        }
+    }
+    if (risk) risk->onMarket(S);   // the band centre for the next tick's orders
+}
+
+// -------------------------
+// Streaming indicators
+// With indicators.trend other than "sma" both crossover lines come from an
+// IndicatorBank: lanes [0, n) carry the short lookback of each of n
+// underlyings and lanes [n, 2n) the long one ("median" reads the lanes'
+// rolling medians). With indicators.vol = "regime" or "quantile" the
+// volatility the signals see is the bank's regime filter estimate, or its
+// robust quantile estimate over vol_window ticks, for each underlying
+// instead of the rolling window.
+// -------------------------
+inline bool usesStreamingBank(const SimParams& p) { return p.trend != TREND_SMA || p.volSource != VOL_WINDOW; }
+
+inline std::size_t streamingBankArenaBytes(const SimParams& p, int underlyings) {
+    const int maxLookback = std::max(p.shortWindow, p.longWindow);
+    std::size_t bytes = IndicatorBank::arenaBytes(2 * underlyings, underlyings, maxLookback) + sizeof(IndicatorBank) + 64;
+    if (p.trend == TREND_MEDIAN) bytes += IndicatorBank::medianArenaBytes(2 * underlyings, maxLookback);
+    if (p.volSource == VOL_QUANTILE) bytes += IndicatorBank::quantileVolArenaBytes(underlyings, p.volWindow);
+    return bytes;
+}
+
+// Returns nullptr when neither the crossover nor the volatility streams;
+// a regime-only bank has no lanes
+inline IndicatorBank* makeStreamingBank(const SimParams& p, Arena& arena, int underlyings, const double* firstPrices) {
+    if (!usesStreamingBank(p)) return nullptr;
+    const int lanes = p.trend != TREND_SMA ? 2 * underlyings : 0;
+    IndicatorBank* bank = static_cast<IndicatorBank*>(arena.allocate(sizeof(IndicatorBank), alignof(IndicatorBank)));
+    new (bank) IndicatorBank(lanes, underlyings, std::max(p.shortWindow, p.longWindow), p.atrBar, arena);
+    for (int u = 0; u < lanes / 2; u++) {
+        bank->setLane(u, u, p.shortWindow);
+        bank->setLane(underlyings + u, u, p.longWindow);
+    }
+    if (p.trend == TREND_MEDIAN) bank->setMedians(arena);
+    if (p.volSource == VOL_REGIME) bank->setRegime(p.regimeLowVol, p.regimeHighVol, p.regimeSwitch);
+    if (p.volSource == VOL_QUANTILE) bank->setQuantileVol(p.volWindow, p.volQuantile, arena);
+    bank->reset(firstPrices);
+    return bank;
+}
+
+inline const double* trendLine(const SimParams& p, const IndicatorBank& bank) {
+    switch (p.trend) {
+    case TREND_EMA: return bank.ema();
+    case TREND_DEMA: return bank.dema();
+    case TREND_MEDIAN: return bank.median();
+    }
+    return bank.kama();
+}
+
+inline const double* streamedVol(const SimParams& p, const IndicatorBank& bank) {
+    return p.volSource == VOL_REGIME ? bank.regimeVol() : bank.quantileVol();
+}
+
+// Indicators, signals and execution for tick t; prices[0..t] must be valid.
+// A streaming bank is advanced to tick t and supplies what it streams.
+template <class Path>
+inline void processTick(const SimParams& p, StrategyBook& book, SimMemory& mem,
+                        const Path& prices, int t, const OptionChain* chain = nullptr,
+                        IndicatorBank* bank = nullptr) {
+    // ----- Compute indicators (if enough data) -----
+    if (bank) {
+        double S = prices[t];
+        bank->update(&S);
+    }
+    double shortMA, longMA;
+    if (p.trend != TREND_SMA) {
+        shortMA = trendLine(p, *bank)[0];
+        longMA  = trendLine(p, *bank)[1];
+    } else {
+        shortMA = computeMA(prices, t, p.shortWindow);
+        longMA  = computeMA(prices, t, p.longWindow);
+    }
+    double volatility = p.volSource != VOL_WINDOW ? streamedVol(p, *bank)[0]
+                                                  : computeVolatility(prices, t, p.volWindow, mem.arena);
+
+    // ----- Generate alpha signals for each strategy -----
+    SignalMask signals;
+    signalKernel(p, &shortMA, &longMA, &volatility, 1, &signals);
+
+    // ----- Execute trades for each strategy -----
+    executeStrategies(p, book, mem, t, prices[t], signals, chain);
+}
+
+// Signals for every tick of a stored path, as processTick computes them
+// (signals[0] is empty). The indicator scratch is released before returning.
+inline void computeSignals(const SimParams& p, SimMemory& mem, const double* prices, int n, SignalMask* signals) {
+    std::size_t mark = mem.arena.mark();
+    IndicatorBank* bank = makeStreamingBank(p, mem.arena, 1, prices);
+    signals[0] = 0;
+    for (int t = 1; t < n; t++) {
+        if (bank) bank->update(&prices[t]);
+        double shortMA, longMA;
+        if (p.trend != TREND_SMA) {
+            shortMA = trendLine(p, *bank)[0];
+            longMA = trendLine(p, *bank)[1];
+        } else {
+            shortMA = computeMA(prices, t, p.shortWindow);
+            longMA = computeMA(prices, t, p.longWindow);
+        }
+        double vol = p.volSource != VOL_WINDOW ? streamedVol(p, *bank)[0]
+                                               : computeVolatility(prices, t, p.volWindow, mem.arena);
+        signalKernel(p, &shortMA, &longMA, &vol, 1, &signals[t]);
+    }
+    mem.arena.rewind(mark);
+}
+
+// -------------------------
+// Batched tick processing
+// Runs ticks 1.. in blocks of p.batch, one stage at a time: GBM prices for
+// the block (unless the path is cached), then each indicator over the
+// block, then the signal kernel, and only then the sequential position
+// logic (with the option chain update, which the execution stage reads).
+// Every stage does the same arithmetic in the same order as processTick,
+// so results match the per-tick loop exactly. Returns option-chain time.
+// -------------------------
+inline double runTickBatches(const SimParams& p, StrategyBook& book, SimMemory& mem,
+                             const double* prices, double* generated,
+                             std::default_random_engine& generator,
+                             std::normal_distribution<double>& distribution,
+                             OptionChain* chain, Telemetry* telemetry, PositionMarker* marker,
+                             IndicatorBank* bank) {
+    const int batch = p.batch;
+    double* shortMA = mem.arena.allocArray<double>(batch);
+    double* longMA  = mem.arena.allocArray<double>(batch);
+    double* vol     = mem.arena.allocArray<double>(batch);
+    SignalMask* signals = mem.arena.allocArray<SignalMask>(batch);
+    double chainNs = 0;
+
+    for (int t0 = 1; t0 < p.totalTicks; t0 += batch) {
+        const int n = std::min(batch, p.totalTicks - t0);
+
+        // ----- Prices for the block -----
+        if (generated)
+            for (int j = 0; j < n; j++)
+                generated[t0 + j] = gbmStep(p.model, generated[t0 + j - 1], distribution(generator));
+
+        // ----- Indicators for the block -----
+        if (bank) {
+            // Streamed values are read tick by tick, as the bank advances
+            for (int j = 0; j < n; j++) {
+                bank->update(&prices[t0 + j]);
+                if (p.trend != TREND_SMA) {
+                    shortMA[j] = trendLine(p, *bank)[0];
+                    longMA[j] = trendLine(p, *bank)[1];
+                }
+                if (p.volSource != VOL_WINDOW) vol[j] = streamedVol(p, *bank)[0];
+            }
+        }
+        if (p.trend == TREND_SMA) {
+            for (int j = 0; j < n; j++) shortMA[j] = computeMA(prices, t0 + j, p.shortWindow);
+            for (int j = 0; j < n; j++) longMA[j] = computeMA(prices, t0 + j, p.longWindow);
+        }
+        if (p.volSource == VOL_WINDOW)
+            for (int j = 0; j < n; j++) vol[j] = computeVolatility(prices, t0 + j, p.volWindow, mem.arena);
+
+        // ----- Signals for the block -----
+        signalKernel(p, shortMA, longMA, vol, n, signals);
+
+        // ----- Execution, tick by tick -----
+        for (int j = 0; j < n; j++) {
+            const int t = t0 + j;
+            if (chain) {
+                std::chrono::steady_clock::time_point c0 = std::chrono::steady_clock::now();
+                chain->update(prices[t], t);
+                chainNs += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - c0).count();
+            }
+            if (book.lifecycle) settleExpiries(p, &book, 1, &prices[t], t, mem);
+            executeStrategies(p, book, mem, t, prices[t], signals[j], chain);
+            if (marker) marker->markPositions(book.active, t, prices[t]);
+            if (telemetry) telemetry->onTick(t, prices[t], book.active, book.cumulativePnL, book.tradeCount);
+        }
+    }
+    return chainNs;
+}
+
+// -------------------------
+// Single-path simulation
+// Generates a GBM path tick by tick from the given seed and runs all five
+// strategies over it, per tick or in batches of run.batch ticks. With a
+// cached path (the same seed's prices, e.g. from PathCache) nothing is
+// generated and the prices are only read.
+// With telemetry, the loop publishes live PnL and positions to it. With
+// american marking, open positions are valued on a lattice every tick.
+// -------------------------
+inline SimResult runSimulation(const SimParams& p, SimMemory& mem, uint64_t seed,
+                               const double* cachedPath = nullptr, Telemetry* telemetry = nullptr) {
+    StrategyBook book;
+    std::size_t arenaMark = mem.arena.mark();
+    double* generated = cachedPath ? nullptr : mem.arena.allocArray<double>(p.totalTicks);
+    const double* prices = cachedPath ? cachedPath : generated;
+    if (generated) generated[0] = p.model.S0;
+
+    // Set up random number generator for GBM simulation
+    std::default_random_engine generator((unsigned)seed);
+    std::normal_distribution<double> distribution(0.0, 1.0);
+
+    OptionChain* chain = nullptr;
+    if (p.chain.enabled) {
+        chain = static_cast<OptionChain*>(mem.arena.allocate(sizeof(OptionChain), alignof(OptionChain)));
+        new (chain) OptionChain(p.chain, p.model.S0, seed, mem.arena);
+    }
+    double chainNs = 0;
+
+    PositionMarker* marker = nullptr;
+    if (p.american.enabled) {
+        marker = static_cast<PositionMarker*>(mem.arena.allocate(sizeof(PositionMarker), alignof(PositionMarker)));
+        new (marker) PositionMarker(p, mem.arena);
+    }
+
+    IndicatorBank* bank = makeStreamingBank(p, mem.arena, 1, prices);
+    book.risk = makeRiskEngine(p, mem.arena, prices[0]);
+    book.lifecycle = makeLifecycle(p, mem.arena);
+
+    std::size_t allocsBeforeLoop = heapAllocCount().load();
+
+    if (p.batch > 1) {
+        chainNs = runTickBatches(p, book, mem, prices, generated, generator, distribution, chain, telemetry, marker,
+                                 bank);
+    } else {
+        // Main simulation loop
+        for (int t = 1; t < p.totalTicks; t++) {
+            // ----- Simulate underlying price using GBM -----
+            if (generated) generated[t] = gbmStep(p.model, generated[t - 1], distribution(generator));
+            if (chain) {
+                std::chrono::steady_clock::time_point c0 = std::chrono::steady_clock::now();
+                chain->update(prices[t], t);
+                chainNs += std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - c0).count();
+            }
+            if (book.lifecycle) settleExpiries(p, &book, 1, &prices[t], t, mem);
+            processTick(p, book, mem, prices, t, chain, bank);
+            if (marker) marker->markPositions(book.active, t, prices[t]);
+            if (telemetry) telemetry->onTick(t, prices[t], book.active, book.cumulativePnL, book.tradeCount);
+        }
+    }
+
+    SimResult r;
+    r.loopAllocs = heapAllocCount().load() - allocsBeforeLoop;
+    r.chainNsPerTick = chainNs / (p.totalTicks - 1);
+    r.markNsPerTick = marker ? marker->nsPerMark() : 0.0;
+    r.risk = riskStats(book.risk);
+    r.expiry = expiryStats(book.lifecycle, &book, 1, &prices[p.totalTicks - 1], p.totalTicks - 1);
+    for (int i = 0; i < 6; i++) {
+        r.openMark[i] = marker ? marker->mark[i] : 0.0;
+        r.cumulativePnL[i] = book.cumulativePnL[i];
+        r.tradeCount[i] = book.tradeCount[i];
+        r.fees[i] = book.fees[i];
+        r.slippage[i] = book.slippage[i];
+        r.impact[i] = book.impact[i];
+        // Trades still open at the end are never realised
+        if (book.active[i]) mem.trades.release(book.active[i]);
+    }
+    mem.arena.rewind(arenaMark);
+    return r;
+}
+
+// Runs all five strategies over an existing path, a price array or a lazy
+// view over one; nothing is generated and no chain or telemetry is used.
+template <class Path>
+inline SimResult runOnPath(const SimParams& p, SimMemory& mem, const Path& prices) {
+    StrategyBook book;
+    std::size_t arenaMark = mem.arena.mark();
+    double S0 = prices[0];
+    IndicatorBank* bank = makeStreamingBank(p, mem.arena, 1, &S0);
+    book.risk = makeRiskEngine(p, mem.arena, S0);
+    for (int t = 1; t < p.totalTicks; t++) processTick(p, book, mem, prices, t, nullptr, bank);
+
+    SimResult r;
+    r.loopAllocs = 0;
+    r.chainNsPerTick = 0.0;
+    r.markNsPerTick = 0.0;
+    r.risk = riskStats(book.risk);
+    r.expiry = expiryStats(nullptr, &book, 1, nullptr, 0);   // no lifecycle on a replayed path
+    for (int i = 0; i < 6; i++) {
+        r.cumulativePnL[i] = book.cumulativePnL[i];
+        r.tradeCount[i] = book.tradeCount[i];
+        r.fees[i] = book.fees[i];
+        r.slippage[i] = book.slippage[i];
+        r.impact[i] = book.impact[i];
+        r.openMark[i] = 0.0;
+        if (book.active[i]) mem.trades.release(book.active[i]);
+    }
+    mem.arena.rewind(arenaMark);
+    return r;
+}
+
+#endif // SIMULATION_H
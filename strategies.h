@@ -0,0 +1,210 @@
+#ifndef STRATEGIES_H
+#define STRATEGIES_H
+
+#include <algorithm>
+#include <cstdint>
+#include "config.h"
+
+// Strategy types; also the index into every per-strategy array
+enum StrategyType {
+    STRADDLE  = 1,
+    STRANGLE  = 2,
+    BULL      = 3,
+    BEAR      = 4,
+    BUTTERFLY = 5
+};
+
+// Trade structure for each strategy's open trade
+struct Trade {
+    int strategyType;    // 1: Straddle, 2: Strangle, 3: Bull Spread, 4: Bear Spread, 5: Butterfly Spread
+    int entryTick;
+    int exitTick;
+    double entryPrice;
+    double exitPrice;
+    // For options legs, we use strikes computed at entry.
+    double strike1, strike2, strike3;
+    int volume;
+    double payoff;
+    bool open;
+    // Option lifecycle (expiry enabled): listed expiry, premium paid per
+    // unit of volume, and links in the expiry wheel
+    int expiryTick;      // 0 without expiries
+    double premium;
+    int underlying;      // asset index in multi mode
+    Trade* wheelPrev;
+    Trade* wheelNext;
+};
+
+// -------------------------
+// Option Payoff Functions
+// (Assuming zero premiums for simplicity)
+// Templated on the number type: double in the simulation, Adouble (aad.h)
+// for sensitivities.
+// -------------------------
+
+// max(x, 0), as std::max(x, 0.0) picks it
+template <class T>
+inline T positivePart(const T& x) { return x < 0.0 ? T(0.0) : x; }
+
+template <class T>
+inline T straddlePayoff(const T& S, const T& K) {
+    T call = positivePart(S - K);
+    T put  = positivePart(K - S);
+    return call + put;
+}
+
+template <class T>
+inline T stranglePayoff(const T& S, const T& K1, const T& K2) {
+    T put  = positivePart(K1 - S);
+    T call = positivePart(S - K2);
+    return put + call;
+}
+
+template <class T>
+inline T bullSpreadPayoff(const T& S, const T& K1, const T& K2) {
+    T longCall  = positivePart(S - K1);
+    T shortCall = positivePart(S - K2);
+    return longCall - shortCall;
+}
+
+template <class T>
+inline T bearSpreadPayoff(const T& S, const T& K1, const T& K2) {
+    T longPut  = positivePart(K1 - S);
+    T shortPut = positivePart(S - K2);
+    return longPut - shortPut;
+}
+
+template <class T>
+inline T butterflySpreadPayoff(const T& S, const T& K1, const T& K2, const T& K3) {
+    T longCall1  = positivePart(S - K1);
+    T shortCalls = 2.0 * positivePart(S - K2);
+    T longCall2  = positivePart(S - K3);
+    return longCall1 - shortCalls + longCall2;
+}
+
+// Payoff per contract of strategy `type`'s structure with strikes K at S
+template <class T>
+inline T structurePayoff(int type, const T& S, const T K[3]) {
+    switch (type) {
+    case STRADDLE:  return straddlePayoff(S, K[0]);
+    case STRANGLE:  return stranglePayoff(S, K[0], K[1]);
+    case BULL:      return bullSpreadPayoff(S, K[0], K[1]);
+    case BEAR:      return bearSpreadPayoff(S, K[0], K[1]);
+    case BUTTERFLY: return butterflySpreadPayoff(S, K[0], K[1], K[2]);
+    }
+    return T(0.0);
+}
+
+// Payoff per contract of a trade closed at underlying price S
+inline double tradePayoff(const Trade& tr, double S) {
+    const double K[3] = {tr.strike1, tr.strike2, tr.strike3};
+    return structurePayoff(tr.strategyType, S, K);
+}
+
+// Slope of the payoff per contract at S (intrinsic delta); 0 at a kink
+inline double tradeDelta(const Trade& tr, double S) {
+    double c1 = S > tr.strike1 ? 1.0 : 0.0, p1 = S < tr.strike1 ? -1.0 : 0.0;
+    double c2 = S > tr.strike2 ? 1.0 : 0.0;
+    switch (tr.strategyType) {
+    case STRADDLE:  return c1 + p1;
+    case STRANGLE:  return p1 + c2;
+    case BULL:      return c1 - c2;
+    case BEAR:      return p1 - c2;   // follows bearSpreadPayoff's short leg
+    case BUTTERFLY: return c1 - 2.0 * c2 + (S > tr.strike3 ? 1.0 : 0.0);
+    }
+    return 0.0;
+}
+
+// Strikes of strategy `type`'s structure around the entry price S, strike
+// offset delta; strikes the structure does not use are set to S
+template <class T>
+inline void structureStrikes(int type, const T& S, const T& delta, T K[3]) {
+    K[0] = K[1] = K[2] = S;
+    switch (type) {
+    case STRADDLE:
+        // For a straddle, we use the entry price as the strike.
+        break;
+    case STRANGLE:
+        // For a strangle, use lower and higher strikes around the entry price.
+        K[0] = S * (1 - delta);
+        K[1] = S * (1 + delta);
+        break;
+    case BULL:
+        // For a bull spread, choose strikes below and above the entry price.
+        K[0] = S * (1 - delta); // long call
+        K[1] = S * (1 + delta); // short call
+        break;
+    case BEAR:
+        // For a bear spread, use a higher strike for the long put and a lower strike for the short put.
+        K[0] = S * (1 + delta); // long put strike
+        K[1] = S * (1 - delta); // short put strike
+        break;
+    case BUTTERFLY:
+        // For a butterfly spread, use three strikes:
+        K[0] = S * (1 - delta);
+        K[1] = S;
+        K[2] = S * (1 + delta);
+        break;
+    }
+}
+
+inline void setStrikes(Trade& tr, double S, double delta) {
+    double K[3];
+    structureStrikes(tr.strategyType, S, delta, K);
+    tr.strike1 = K[0];
+    tr.strike2 = K[1];
+    tr.strike3 = K[2];
+}
+
+// -------------------------
+// Alpha signals
+// +1 means "enter" (or hold long), -1 means "exit", 0 means no view.
+// Disabled strategies always get 0.
+// Signals are packed into one 16-bit mask per lane: bit k is "enter" for
+// strategy k and bit 8 + k is "exit". Each bit is a plain comparison, so
+// the kernel has no data-dependent branches and compiles to SIMD compares
+// over a block of lanes (ticks, or underlyings in portfolio mode).
+// -------------------------
+typedef uint16_t SignalMask;
+
+inline bool signalEnter(SignalMask m, int k) { return (m >> k) & 1; }
+inline bool signalExit(SignalMask m, int k) { return (m >> (8 + k)) & 1; }
+
+// Lanes [0, n): masks[i] from shortMA[i], longMA[i] and vol[i]
+inline void signalKernel(const SimParams& p, const double* __restrict shortMA, const double* __restrict longMA,
+                         const double* __restrict vol, int n, SignalMask* __restrict masks) {
+    const StrategyParams* sp = p.strategy;
+    // Thresholds in locals so the loop does not reload them through p
+    const double straddleIn = sp[STRADDLE].entryThreshold, straddleOut = sp[STRADDLE].exitThreshold;
+    const double strangleIn = sp[STRANGLE].entryThreshold, strangleOut = sp[STRANGLE].exitThreshold;
+    const double butterflyIn = sp[BUTTERFLY].entryThreshold, butterflyOut = sp[BUTTERFLY].exitThreshold;
+    unsigned enabled = 0;
+    for (int k = 1; k <= 5; k++) enabled |= (sp[k].enabled ? 0x101u : 0u) << k;
+
+    for (int i = 0; i < n; i++) {
+        const double v = vol[i];
+        // Straddle/strangle: long if high volatility, exit if low.
+        // Butterfly: profits from low volatility.
+        unsigned straddle = v > straddleIn, strangle = v > strangleIn, butterfly = v < butterflyIn;
+        // Bull spread expects upward movement (short MA above long MA),
+        // bear spread downward; each exits whenever it does not enter.
+        unsigned bull = shortMA[i] > longMA[i], bear = shortMA[i] < longMA[i];
+        unsigned enter = straddle << STRADDLE | strangle << STRANGLE | bull << BULL | bear << BEAR | butterfly << BUTTERFLY;
+        unsigned exit = ((unsigned)(v < straddleOut) & (straddle ^ 1u)) << STRADDLE
+                      | ((unsigned)(v < strangleOut) & (strangle ^ 1u)) << STRANGLE
+                      | (bull ^ 1u) << BULL
+                      | (bear ^ 1u) << BEAR
+                      | ((unsigned)(v >= butterflyOut) & (butterfly ^ 1u)) << BUTTERFLY;
+        masks[i] = (SignalMask)((enter | exit << 8) & enabled);
+    }
+}
+
+// Single-lane form as per-strategy alpha values
+inline void generateSignals(const SimParams& p, double shortMA, double longMA, double volatility, int alpha[6]) {
+    SignalMask m;
+    signalKernel(p, &shortMA, &longMA, &volatility, 1, &m);
+    alpha[0] = 0;
+    for (int k = 1; k <= 5; k++) alpha[k] = (int)signalEnter(m, k) - (int)signalExit(m, k);
+}
+
+#endif // STRATEGIES_H
@@ -0,0 +1,165 @@
+#ifndef STRESS_H
+#define STRESS_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+#include "arena.h"
+#include "config.h"
+#include "simulation.h"
+
+enum ScenarioKind { SCEN_BASE = 0, SCEN_GAP, SCEN_VOL_SPIKE, SCEN_CRASH, SCEN_TREND };
+
+// -------------------------
+// Scenario views
+// Every scenario is a piecewise-affine map in log-price space applied to
+// the shared base path: unchanged before t0, then
+//   log S'(t) = a + b log S(t) + c t
+// with one (a, b, c) inside [t0, t1] and another after t1. Gaps, volatility
+// spikes, flash crashes with recovery and trending regimes are all of this
+// form, so a scenario is a few coefficients and prices are computed on
+// access from the base path rather than copied.
+// -------------------------
+struct ScenarioView {
+    const double* base;
+    const double* logBase;
+    int t0, t1;
+    double a1, b1, c1;   // t0 <= t <= t1
+    double a2, b2, c2;   // t > t1
+
+    double operator[](int t) const {
+        if (t < t0) return base[t];
+        if (t <= t1) return std::exp(a1 + b1 * logBase[t] + c1 * t);
+        return std::exp(a2 + b2 * logBase[t] + c2 * t);
+    }
+};
+
+struct Scenario {
+    int kind;        // ScenarioKind
+    double size;     // gap return, vol factor, crash depth or drift per tick
+    int start;       // first affected tick
+    ScenarioView view;
+};
+
+// Builds the view for a scenario of the given kind over [start, start + window)
+inline ScenarioView makeScenarioView(int kind, double size, int start, int window, int ticks,
+                                     const double* base, const double* logBase) {
+    ScenarioView v;
+    v.base = base;
+    v.logBase = logBase;
+    v.t0 = kind == SCEN_BASE ? ticks : start;
+    v.t1 = std::min(ticks - 1, start + window - 1);
+    v.a1 = v.a2 = v.c1 = v.c2 = 0.0;
+    v.b1 = v.b2 = 1.0;
+    const double L0 = logBase[std::min(v.t0, ticks - 1)], L1 = logBase[v.t1];
+    switch (kind) {
+    case SCEN_GAP:
+        // Permanent jump of `size` (as a return) at t0
+        v.a1 = v.a2 = std::log1p(size);
+        break;
+    case SCEN_VOL_SPIKE:
+        // Log returns inside the window scaled by `size`; later prices
+        // carry the extra move
+        v.a1 = (1.0 - size) * L0;
+        v.b1 = size;
+        v.a2 = (size - 1.0) * (L1 - L0);
+        break;
+    case SCEN_CRASH: {
+        // Drop of `size` at t0, recovered linearly (in log terms) by t1
+        double drop = std::log1p(-size);
+        double span = (double)(v.t1 - v.t0 + 1);
+        v.c1 = -drop / span;
+        v.a1 = drop - v.c1 * v.t0;
+        break;
+    }
+    case SCEN_TREND:
+        // Extra drift of `size` per tick inside the window, kept afterwards
+        v.c1 = size;
+        v.a1 = -size * v.t0;
+        v.a2 = size * (v.t1 - v.t0);
+        break;
+    }
+    return v;
+}
+
+// -------------------------
+// Stress engine
+// Generates one base path, builds the scenario library from the [stress]
+// grids (every size of every kind at each start tick, plus the unshocked
+// base), and runs all five strategies over every scenario on a pool of
+// threads, each with its own SimMemory. Threads claim scenarios from an
+// atomic counter. The result is a scenario x strategy PnL matrix.
+// -------------------------
+class StressEngine {
+public:
+    StressEngine(const SimParams& p, SimMemory& mem, uint64_t seed) : p_(p) {
+        const int n = p.totalTicks;
+        base_ = mem.arena.allocArray<double>(n);
+        logBase_ = mem.arena.allocArray<double>(n);
+        generatePath(p.model, seed, base_, n);
+        for (int t = 0; t < n; t++) logBase_[t] = std::log(base_[t]);
+
+        const StressParams& sp = p.stress;
+        add(SCEN_BASE, 0.0, 0);
+        const std::vector<double>* sizes[5] = {nullptr, &sp.gaps, &sp.volSpikes, &sp.crashes, &sp.trends};
+        for (int s = 0; s < sp.starts; s++) {
+            // Start ticks spread evenly, leaving room for the indicators to warm up
+            int warm = std::max(p.longWindow, p.volWindow);
+            int start = warm + (int)((double)(n - warm) * (s + 0.5) / sp.starts);
+            for (int kind = SCEN_GAP; kind <= SCEN_TREND; kind++)
+                for (size_t i = 0; i < sizes[kind]->size(); i++) add(kind, (*sizes[kind])[i], start);
+        }
+    }
+
+    static size_t arenaBytes(const SimParams& p) { return 2 * (size_t)p.totalTicks * sizeof(double) + 2 * 64; }
+
+    // Fills pnl[scenario * 6 + strategy] and each scenario's risk-check
+    // counts; returns wall time in ms
+    double run(std::vector<double>& pnl, std::vector<RiskStats>& risk) {
+        pnl.assign(scenarios_.size() * 6, 0.0);
+        risk.resize(scenarios_.size());
+        std::atomic<size_t> next(0);
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        std::vector<std::thread> pool;
+        for (int t = 1; t < p_.stress.threads; t++)
+            pool.push_back(std::thread(&StressEngine::worker, this, std::ref(next), std::ref(pnl), std::ref(risk)));
+        worker(next, pnl, risk);
+        for (size_t i = 0; i < pool.size(); i++) pool[i].join();
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    const std::vector<Scenario>& scenarios() const { return scenarios_; }
+
+private:
+    void add(int kind, double size, int start) {
+        Scenario s;
+        s.kind = kind;
+        s.size = size;
+        s.start = start;
+        s.view = makeScenarioView(kind, size, start, p_.stress.window, p_.totalTicks, base_, logBase_);
+        scenarios_.push_back(s);
+    }
+
+    void worker(std::atomic<size_t>& next, std::vector<double>& pnl, std::vector<RiskStats>& risk) {
+        SimMemory mem(p_.memory);
+        for (;;) {
+            size_t i = next.fetch_add(1);
+            if (i >= scenarios_.size()) break;
+            SimResult r = runOnPath(p_, mem, scenarios_[i].view);
+            for (int k = 0; k < 6; k++) pnl[i * 6 + k] = r.cumulativePnL[k];
+            risk[i] = r.risk;
+        }
+    }
+
+    const SimParams& p_;
+    double* base_;
+    double* logBase_;
+    std::vector<Scenario> scenarios_;
+};
+
+#endif // STRESS_H
@@ -0,0 +1,164 @@
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include "config.h"
+#include "expiry.h"
+#include "strategies.h"
+
+// Live view of a run, as an external monitor reads it
+struct TelemetrySnapshot {
+    uint64_t tick;
+    uint64_t totalTicks;
+    uint64_t path;            // current path (paths mode), from 0
+    uint64_t paths;
+    uint64_t updates;         // snapshots published so far
+    double price;             // underlying at this tick
+    double pnl[6];            // realised PnL per strategy (1..5)
+    int32_t trades[6];        // closed trades per strategy
+    int32_t openVolume[6];    // contracts in the open trade, 0 when flat
+    double delta[6];          // Black-Scholes delta of the open trade
+    double gamma[6];          // and its gamma
+    double vega[6];           // and vega, per unit of model.sigma
+    double nsPerTick;         // wall time per tick over the last interval
+    double maxNsPerTick;      // worst interval of the run so far
+};
+
+// Layout of the shared-memory object. The writer bumps seq to an odd value,
+// writes the snapshot, then bumps it to even; readers retry while seq is
+// odd or changed under them.
+struct TelemetryRegion {
+    char magic[8];                 // "HFTTELE2"
+    int32_t writerPid;
+    std::atomic<uint32_t> done;    // set once the run has finished
+    alignas(64) std::atomic<uint64_t> seq;
+    TelemetrySnapshot snap;
+};
+
+// Reads a consistent snapshot; returns false if the writer kept
+// overwriting it for `attempts` tries.
+inline bool readTelemetry(const TelemetryRegion* r, TelemetrySnapshot& out, int attempts = 1000) {
+    for (int i = 0; i < attempts; i++) {
+        uint64_t s0 = r->seq.load(std::memory_order_acquire);
+        if (s0 & 1) continue;
+        std::memcpy(&out, &r->snap, sizeof(out));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (r->seq.load(std::memory_order_relaxed) == s0) return true;
+    }
+    return false;
+}
+
+// -------------------------
+// Telemetry writer
+// Owns a POSIX shared-memory object that the simulation publishes to every
+// interval ticks. Publishing is plain stores bracketed by the seqlock
+// counter, plus one clock read (vDSO, no syscall) per interval, so the hot
+// loop never blocks on a reader and never enters the kernel.
+// -------------------------
+class Telemetry {
+public:
+    Telemetry(const SimParams& p, uint64_t paths)
+        : region_(nullptr), interval_(p.telemetry.intervalTicks > 0 ? p.telemetry.intervalTicks : 1),
+          countdown_(interval_), sigma_(p.model.sigma), dt_(p.model.dt),
+          rate_(p.expiry.enabled ? p.expiry.rate : p.american.rate) {
+        const std::string& name = p.telemetry.name;
+        for (int k = 0; k < 6; k++) holdPeriod_[k] = p.strategy[k].holdPeriod;
+        int fd = shm_open(name.c_str(), O_CREAT | O_RDWR, 0644);
+        if (fd < 0) throw std::runtime_error("cannot open telemetry region " + name);
+        if (ftruncate(fd, sizeof(TelemetryRegion)) != 0) {
+            close(fd);
+            throw std::runtime_error("cannot size telemetry region " + name);
+        }
+        void* m = mmap(nullptr, sizeof(TelemetryRegion), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        close(fd);
+        if (m == MAP_FAILED) throw std::runtime_error("cannot map telemetry region " + name);
+        std::memset(m, 0, sizeof(TelemetryRegion));
+        region_ = new (m) TelemetryRegion();
+        region_->writerPid = (int32_t)getpid();
+        region_->done.store(0);
+        region_->seq.store(0);
+        std::memset(&region_->snap, 0, sizeof(region_->snap));
+        region_->snap.totalTicks = (uint64_t)p.totalTicks;
+        region_->snap.paths = paths;
+        std::memcpy(region_->magic, "HFTTELE2", 8);
+        last_ = std::chrono::steady_clock::now();
+    }
+
+    // The region stays behind, marked done, so a monitor sees the final state
+    ~Telemetry() {
+        if (!region_) return;
+        region_->done.store(1, std::memory_order_release);
+        munmap(region_, sizeof(TelemetryRegion));
+    }
+
+    Telemetry(const Telemetry&) = delete;
+    Telemetry& operator=(const Telemetry&) = delete;
+
+    void beginPath(uint64_t path) {
+        region_->snap.path = path;
+        countdown_ = interval_;
+        last_ = std::chrono::steady_clock::now();
+    }
+
+    // Called once per tick from the simulation loop
+    void onTick(int t, double S, const Trade* const active[6], const double cumulativePnL[6], const int tradeCount[6]) {
+        if (--countdown_) return;
+        countdown_ = interval_;
+        publish(t, S, active, cumulativePnL, tradeCount);
+    }
+
+private:
+    void publish(int t, double S, const Trade* const active[6], const double cumulativePnL[6], const int tradeCount[6]) {
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        double ns = std::chrono::duration<double, std::nano>(now - last_).count() / interval_;
+        last_ = now;
+
+        TelemetrySnapshot& s = region_->snap;
+        uint64_t seq = region_->seq.load(std::memory_order_relaxed);
+        region_->seq.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        s.tick = (uint64_t)t;
+        s.updates++;
+        s.price = S;
+        for (int k = 1; k <= 5; k++) {
+            const Trade* tr = active[k];
+            s.pnl[k] = cumulativePnL[k];
+            s.trades[k] = tradeCount[k];
+            s.openVolume[k] = tr ? tr->volume : 0;
+            Greeks g = {0.0, 0.0, 0.0};
+            if (tr) g = structureGreeks(*tr, S, (expiry(*tr) - t) * dt_, sigma_, rate_);
+            s.delta[k] = g.delta * s.openVolume[k];
+            s.gamma[k] = g.gamma * s.openVolume[k];
+            s.vega[k] = g.vega * s.openVolume[k];
+        }
+        s.nsPerTick = ns;
+        if (ns > s.maxNsPerTick) s.maxNsPerTick = ns;
+        region_->seq.store(seq + 2, std::memory_order_release);
+    }
+
+    // Listed expiry with expiries on; otherwise the legs expire when the
+    // holding period ends, as american marking assumes
+    int expiry(const Trade& tr) const {
+        return tr.expiryTick ? tr.expiryTick : tr.entryTick + holdPeriod_[tr.strategyType];
+    }
+
+    TelemetryRegion* region_;
+    int interval_;
+    int countdown_;
+    double sigma_;
+    double dt_;
+    double rate_;
+    int holdPeriod_[6];
+    std::chrono::steady_clock::time_point last_;
+};
+
+#endif // TELEMETRY_H